@@ -0,0 +1,166 @@
+// Замер скорости разбора JSON на большом файле запросов.
+//
+//   json_bench [файл] [повторы]
+//
+// Без файла генерируется вход около 100 МБ того же вида, что и запросы
+// справочника: остановки с расстояниями, автобусы и stat_requests. Для
+// каждого способа разбора выводится лучшее время из нескольких повторов и
+// скорость в МБ/с. Строка istream_dom - вход json::Load(std::istream&),
+// который есть во всех версиях парсера. Для сравнения с версией без
+// буферного разбора файл собирается с её json.cpp и макросом
+// JSON_BENCH_ISTREAM_ONLY, например для исходной версии:
+//
+//   git show 9585c04:cpp-transport-catalogue/json.h > /tmp/old/json.h
+//   git show 9585c04:cpp-transport-catalogue/json.cpp > /tmp/old/json.cpp
+//   g++ -std=c++17 -O2 -DJSON_BENCH_ISTREAM_ONLY -I/tmp/old
+//       bench/json_bench.cpp /tmp/old/json.cpp -o json_bench_old
+
+#include "json.h"
+#ifndef JSON_BENCH_ISTREAM_ONLY
+#include "json_arena.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+inline constexpr size_t DEFAULT_SIZE = size_t{100} << 20;
+inline constexpr int DEFAULT_REPEATS = 3;
+
+// Вход размером не меньше size байт
+string GenerateRequests(size_t size) {
+  ostringstream out;
+  out << R"({"routing_settings": {"bus_wait_time": 6, "bus_velocity": 40},)"
+      << "\n\"base_requests\": [\n";
+  size_t index = 0;
+  // остановки и автобусы вперемешку, пока не наберётся размер
+  while (static_cast<size_t>(out.tellp()) < size / 2) {
+    out << R"({"type": "Stop", "name": "Stop )" << index
+        << R"(", "latitude": )"
+        << 55.5 + static_cast<double>(index % 997) / 1e4
+        << R"(, "longitude": )"
+        << 37.5 + static_cast<double>(index % 991) / 1e4
+        << R"(, "road_distances": {"Stop )" << index + 1 << R"(": )"
+        << 1000 + index % 3000 << R"(, "Stop A )" << index + 2 << R"(": )"
+        << 500 + index % 2000 << "}},\n";
+    if (index % 8 == 0) {
+      out << R"({"type": "Bus", "name": "Bus )" << index
+          << R"(", "is_roundtrip": false, "stops": [)";
+      for (size_t stop = 0; stop < 12; ++stop) {
+        out << (stop == 0 ? "" : ", ") << "\"Stop " << index + stop << '"';
+      }
+      out << "]},\n";
+    }
+    ++index;
+  }
+  out << R"({"type": "Stop", "name": "Last", "latitude": 55.0, )"
+      << R"("longitude": 37.0}],)" << "\n\"stat_requests\": [\n";
+  for (size_t id = 0; static_cast<size_t>(out.tellp()) < size; ++id) {
+    out << R"({"id": )" << id
+        << (id % 2 == 0 ? R"(, "type": "Bus", "name": "Bus )"
+                        : R"(, "type": "Stop", "name": "Stop )")
+        << (id % 2 == 0 ? id / 8 * 8 : id) << "\"},\n";
+  }
+  out << R"({"id": -1, "type": "Map"}]})";
+  return out.str();
+}
+
+#ifndef JSON_BENCH_ISTREAM_ONLY
+// Считает события разбора, ничего не сохраняя
+class CountingHandler final : public json::Handler {
+public:
+  void StartDict() override { ++events_; }
+  void Key(std::string_view /*key*/) override { ++events_; }
+  void EndDict() override { ++events_; }
+  void StartArray() override { ++events_; }
+  void EndArray() override { ++events_; }
+  void Value(std::nullptr_t /*value*/) override { ++events_; }
+  void Value(bool /*value*/) override { ++events_; }
+  void Value(int /*value*/) override { ++events_; }
+  void Value(double /*value*/) override { ++events_; }
+  void Value(std::string_view /*value*/) override { ++events_; }
+
+  [[nodiscard]] size_t events() const { return events_; }
+
+private:
+  size_t events_{};
+};
+#endif
+
+// Лучшее время run из repeats запусков, в секундах
+double Measure(int repeats, const function<void()> &run) {
+  double best = numeric_limits<double>::max();
+  for (int repeat = 0; repeat < repeats; ++repeat) {
+    const auto start = chrono::steady_clock::now();
+    run();
+    const chrono::duration<double> elapsed =
+        chrono::steady_clock::now() - start;
+    best = min(best, elapsed.count());
+  }
+  return best;
+}
+
+void Report(string_view name, size_t size, double seconds) {
+  cout << left << setw(16) << name << right << fixed << setprecision(3)
+       << setw(8) << seconds << " s " << setprecision(1) << setw(9)
+       << static_cast<double>(size) / static_cast<double>(1 << 20) / seconds
+       << " MB/s" << endl;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  string input;
+  if (argc > 1) {
+    ifstream file(argv[1], ios::binary);
+    if (!file) {
+      cerr << "Can't open " << argv[1] << endl;
+      return 1;
+    }
+    input.assign(istreambuf_iterator<char>(file),
+                 istreambuf_iterator<char>());
+  } else {
+    input = GenerateRequests(DEFAULT_SIZE);
+  }
+  const int repeats = argc > 2 ? max(1, stoi(argv[2])) : DEFAULT_REPEATS;
+  cout << "input: " << input.size() << " bytes, best of " << repeats << endl;
+
+  // нижняя граница: один проход по буферу без разбора
+  size_t quotes = 0;
+  Report("scan", input.size(), Measure(repeats, [&] {
+           quotes =
+               static_cast<size_t>(count(input.begin(), input.end(), '"'));
+         }));
+  Report("istream_dom", input.size(), Measure(repeats, [&] {
+           istringstream stream(input);
+           const json::Document doc = json::Load(stream);
+         }));
+#ifndef JSON_BENCH_ISTREAM_ONLY
+  Report("buffer_dom", input.size(), Measure(repeats, [&] {
+           const json::Document doc = json::Load(string_view(input));
+         }));
+  Report("buffer_arena", input.size(), Measure(repeats, [&] {
+           const json::arena::Document doc =
+               json::arena::Load(string_view(input));
+         }));
+  size_t events = 0;
+  Report("buffer_sax", input.size(), Measure(repeats, [&] {
+           CountingHandler handler;
+           json::Parse(string_view(input), handler);
+           events = handler.events();
+         }));
+  cout << "events: " << events << endl;
+#endif
+  cout << "quotes: " << quotes << endl;
+  return 0;
+}
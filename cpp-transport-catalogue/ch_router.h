@@ -0,0 +1,368 @@
+#pragma once
+
+#include "router.h"
+
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+namespace graph {
+
+// Маршрутизатор на иерархии сжатий (contraction hierarchies).
+// При построении вершины упорядочиваются по важности и поочерёдно стягиваются,
+// сохраняющие кратчайшие пути обходы стянутой вершины добавляются как
+// рёбра-сокращения. Запрос - двунаправленный поиск только "вверх" по иерархии,
+// найденные сокращения раскрываются в рёбра исходного графа.
+template <typename Weight>
+class ContractionHierarchyRouter final : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RouterBase<Weight>::RouteInfo;
+
+    explicit ContractionHierarchyRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    size_t GetShortcutCount() const {
+        return edges_.size() - original_edge_count_;
+    }
+
+private:
+    // Ребро иерархии: первые original_edge_count_ рёбер совпадают с рёбрами
+    // исходного графа (по EdgeId), далее идут сокращения из двух рёбер иерархии
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        std::optional<std::pair<size_t, size_t>> shortcut_of;
+    };
+    using IncidenceList = std::vector<size_t>;
+    // Рёбра между ещё не стянутыми вершинами: соседняя вершина -> самое лёгкое ребро
+    using Neighbours = std::unordered_map<VertexId, size_t>;
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+    using Priority = std::ptrdiff_t;
+
+    // Поиск "свидетелей" - путей в обход стягиваемой вершины
+    class WitnessSearch {
+    public:
+        explicit WitnessSearch(size_t vertex_count)
+            : weights_(vertex_count) {
+        }
+        // Ищет пути из source до соседей excluded, не проходя через excluded
+        void Run(const ContractionHierarchyRouter& router, const std::vector<Neighbours>& out_edges,
+                 VertexId source, VertexId excluded, Weight limit);
+        const std::optional<Weight>& GetWeight(VertexId vertex) const {
+            return weights_[vertex];
+        }
+
+    private:
+        static constexpr size_t SETTLED_LIMIT = 500;
+        std::vector<std::optional<Weight>> weights_;
+        std::vector<VertexId> touched_;
+    };
+
+    // Кандидат в сокращение: пара рёбер (вход в стягиваемую вершину, выход из неё)
+    using ShortcutCandidates = std::vector<std::pair<size_t, size_t>>;
+
+    ShortcutCandidates FindShortcuts(VertexId vertex, const std::vector<Neighbours>& in_edges,
+                                     const std::vector<Neighbours>& out_edges, WitnessSearch& witness_search) const;
+    // Добавляет ребро, если оно легче имеющегося между теми же вершинами
+    void InsertEdge(std::vector<Neighbours>& in_edges, std::vector<Neighbours>& out_edges, size_t edge_id) const;
+    void UnpackEdge(size_t edge_id, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    size_t original_edge_count_ = 0;
+    std::vector<HierarchyEdge> edges_;
+    std::vector<size_t> ranks_;
+    // рёбра к вершинам с большим рангом, для прямого поиска
+    std::vector<IncidenceList> upward_edges_;
+    // рёбра из вершин с большим рангом, для обратного поиска
+    std::vector<IncidenceList> downward_edges_;
+};
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+    : original_edge_count_(graph.GetEdgeCount())
+    , ranks_(graph.GetVertexCount())
+    , upward_edges_(graph.GetVertexCount())
+    , downward_edges_(graph.GetVertexCount())
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<Neighbours> in_edges(vertex_count);
+    std::vector<Neighbours> out_edges(vertex_count);
+    edges_.reserve(original_edge_count_);
+    for (EdgeId edge_id = 0; edge_id < original_edge_count_; ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        edges_.push_back({edge.from, edge.to, edge.weight, std::nullopt});
+        InsertEdge(in_edges, out_edges, edge_id);
+    }
+
+    std::vector<Priority> contracted_neighbours(vertex_count, 0);
+    WitnessSearch witness_search(vertex_count);
+
+    // Приоритет вершины - разность рёбер: сколько сокращений добавится минус
+    // сколько рёбер исчезнет, плюс число уже стянутых соседей для равномерности
+    const auto get_priority = [&](VertexId vertex) {
+        const auto shortcut_count =
+            static_cast<Priority>(FindShortcuts(vertex, in_edges, out_edges, witness_search).size());
+        const auto removed_count = static_cast<Priority>(in_edges[vertex].size() + out_edges[vertex].size());
+        return shortcut_count - removed_count + contracted_neighbours[vertex];
+    };
+
+    using PriorityItem = std::pair<Priority, VertexId>;
+    std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<PriorityItem>> queue;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.emplace(get_priority(vertex), vertex);
+    }
+
+    size_t rank = 0;
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        // ленивое обновление: приоритет мог вырасти после стягивания соседей
+        if (const Priority priority = get_priority(vertex); !queue.empty() && priority > queue.top().first) {
+            queue.emplace(priority, vertex);
+            continue;
+        }
+
+        for (const auto& [in_edge, out_edge] : FindShortcuts(vertex, in_edges, out_edges, witness_search)) {
+            edges_.push_back({edges_[in_edge].from, edges_[out_edge].to,
+                              edges_[in_edge].weight + edges_[out_edge].weight, std::make_pair(in_edge, out_edge)});
+            InsertEdge(in_edges, out_edges, edges_.size() - 1);
+        }
+
+        // оставшиеся рёбра вершины ведут к вершинам с большим рангом
+        ranks_[vertex] = rank++;
+        for (const auto& [neighbour, edge_id] : out_edges[vertex]) {
+            upward_edges_[vertex].push_back(edge_id);
+            in_edges[neighbour].erase(vertex);
+            ++contracted_neighbours[neighbour];
+        }
+        for (const auto& [neighbour, edge_id] : in_edges[vertex]) {
+            downward_edges_[vertex].push_back(edge_id);
+            out_edges[neighbour].erase(vertex);
+            ++contracted_neighbours[neighbour];
+        }
+        Neighbours{}.swap(out_edges[vertex]);
+        Neighbours{}.swap(in_edges[vertex]);
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::InsertEdge(std::vector<Neighbours>& in_edges,
+                                                    std::vector<Neighbours>& out_edges, size_t edge_id) const {
+    const auto& edge = edges_[edge_id];
+    // петли никогда не входят в кратчайший путь
+    if (edge.from == edge.to) {
+        return;
+    }
+    if (const auto [iter, inserted] = out_edges[edge.from].emplace(edge.to, edge_id);
+        !inserted) {
+        if (!(edge.weight < edges_[iter->second].weight)) {
+            return;
+        }
+        iter->second = edge_id;
+    }
+    in_edges[edge.to][edge.from] = edge_id;
+}
+
+template <typename Weight>
+typename ContractionHierarchyRouter<Weight>::ShortcutCandidates
+ContractionHierarchyRouter<Weight>::FindShortcuts(VertexId vertex, const std::vector<Neighbours>& in_edges,
+                                                  const std::vector<Neighbours>& out_edges,
+                                                  WitnessSearch& witness_search) const {
+    ShortcutCandidates result;
+    if (out_edges[vertex].empty()) {
+        return result;
+    }
+    for (const auto& [source, in_edge] : in_edges[vertex]) {
+        std::optional<Weight> limit;
+        for (const auto& [target, out_edge] : out_edges[vertex]) {
+            if (target == source) {
+                continue;
+            }
+            const Weight candidate_weight = edges_[in_edge].weight + edges_[out_edge].weight;
+            if (!limit || *limit < candidate_weight) {
+                limit = candidate_weight;
+            }
+        }
+        if (!limit) {
+            continue;
+        }
+        witness_search.Run(*this, out_edges, source, vertex, *limit);
+        for (const auto& [target, out_edge] : out_edges[vertex]) {
+            if (target == source) {
+                continue;
+            }
+            const Weight candidate_weight = edges_[in_edge].weight + edges_[out_edge].weight;
+            if (const auto& witness_weight = witness_search.GetWeight(target);
+                !witness_weight || candidate_weight < *witness_weight) {
+                result.emplace_back(in_edge, out_edge);
+            }
+        }
+    }
+    return result;
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::WitnessSearch::Run(const ContractionHierarchyRouter& router,
+                                                            const std::vector<Neighbours>& out_edges,
+                                                            VertexId source, VertexId excluded, Weight limit) {
+    for (const VertexId vertex : touched_) {
+        weights_[vertex].reset();
+    }
+    touched_.clear();
+
+    const Neighbours& targets = out_edges[excluded];
+    size_t targets_left = targets.size() - targets.count(source);
+
+    Queue queue;
+    weights_[source] = ZERO_WEIGHT;
+    touched_.push_back(source);
+    queue.emplace(ZERO_WEIGHT, source);
+    // Поиск ограничен, поэтому свидетель может быть не найден - тогда будет
+    // добавлено лишнее сокращение, что не влияет на корректность
+    for (size_t settled = 0; !queue.empty() && settled < SETTLED_LIMIT && targets_left > 0; ++settled) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (*weights_[vertex] < weight) {
+            continue;
+        }
+        if (limit < weight) {
+            break;
+        }
+        if (vertex != source && targets.count(vertex) > 0) {
+            --targets_left;
+        }
+        for (const auto& [target, edge_id] : out_edges[vertex]) {
+            if (target == excluded) {
+                continue;
+            }
+            const Weight candidate_weight = weight + router.edges_[edge_id].weight;
+            auto& target_weight = weights_[target];
+            if (!target_weight) {
+                touched_.push_back(target);
+            }
+            if (!target_weight || candidate_weight < *target_weight) {
+                target_weight = candidate_weight;
+                queue.emplace(candidate_weight, target);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackEdge(size_t edge_id, std::vector<EdgeId>& edges) const {
+    std::vector<size_t> stack{edge_id};
+    while (!stack.empty()) {
+        const size_t current = stack.back();
+        stack.pop_back();
+        if (const auto& shortcut_of = edges_[current].shortcut_of) {
+            stack.push_back(shortcut_of->second);
+            stack.push_back(shortcut_of->first);
+        } else {
+            edges.push_back(current);
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = ranks_.size();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+
+    struct Search {
+        Search(size_t vertex_count, VertexId start)
+            : weights(vertex_count)
+            , prev_edges(vertex_count) {
+            weights[start] = ZERO_WEIGHT;
+            queue.emplace(ZERO_WEIGHT, start);
+        }
+        std::vector<std::optional<Weight>> weights;
+        std::vector<std::optional<size_t>> prev_edges;
+        Queue queue;
+    };
+    Search forward(vertex_count, from);
+    Search backward(vertex_count, to);
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+
+    const auto step = [&](Search& search, const Search& other, bool is_forward) {
+        const auto [weight, vertex] = search.queue.top();
+        search.queue.pop();
+        if (*search.weights[vertex] < weight) {
+            return;
+        }
+        if (const auto& other_weight = other.weights[vertex]) {
+            if (const Weight candidate_weight = weight + *other_weight;
+                !best_weight || candidate_weight < *best_weight) {
+                best_weight = candidate_weight;
+                meeting_vertex = vertex;
+            }
+        }
+        for (const size_t edge_id : is_forward ? upward_edges_[vertex] : downward_edges_[vertex]) {
+            const auto& edge = edges_[edge_id];
+            const VertexId next_vertex = is_forward ? edge.to : edge.from;
+            const Weight candidate_weight = weight + edge.weight;
+            auto& target_weight = search.weights[next_vertex];
+            if (!target_weight || candidate_weight < *target_weight) {
+                target_weight = candidate_weight;
+                search.prev_edges[next_vertex] = edge_id;
+                search.queue.emplace(candidate_weight, next_vertex);
+            }
+        }
+    };
+
+    while (!forward.queue.empty() || !backward.queue.empty()) {
+        // направление, в котором все вершины дальше лучшего пути, исчерпано
+        for (Search* search : {&forward, &backward}) {
+            if (best_weight && !search->queue.empty() && !(search->queue.top().first < *best_weight)) {
+                search->queue = Queue{};
+            }
+        }
+        if (!forward.queue.empty()
+            && (backward.queue.empty() || !(backward.queue.top().first < forward.queue.top().first))) {
+            step(forward, backward, true);
+        } else if (!backward.queue.empty()) {
+            step(backward, forward, false);
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+    std::vector<size_t> hierarchy_edges;
+    for (std::optional<size_t> edge_id = forward.prev_edges[meeting_vertex];
+         edge_id;
+         edge_id = forward.prev_edges[edges_[*edge_id].from])
+    {
+        hierarchy_edges.push_back(*edge_id);
+    }
+    std::reverse(hierarchy_edges.begin(), hierarchy_edges.end());
+    for (std::optional<size_t> edge_id = backward.prev_edges[meeting_vertex];
+         edge_id;
+         edge_id = backward.prev_edges[edges_[*edge_id].to])
+    {
+        hierarchy_edges.push_back(*edge_id);
+    }
+
+    std::vector<EdgeId> edges;
+    for (const size_t edge_id : hierarchy_edges) {
+        UnpackEdge(edge_id, edges);
+    }
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+}  // namespace graph
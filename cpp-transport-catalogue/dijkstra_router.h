@@ -0,0 +1,111 @@
+#pragma once
+
+#include "router.h"
+
+#include <functional>
+#include <queue>
+
+namespace graph {
+
+// Маршрутизатор без предварительного расчёта: каждый запрос решается
+// алгоритмом Дейкстры на двоичной куче. Построение - O(E), память - O(V + E),
+// запрос - O((V + E) log V). Поиск идёт по замороженной CSR-копии графа.
+template <typename Weight>
+class DijkstraRouter final : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RouterBase<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    // Граф перезамораживается целиком: O(V + E), без поисковых структур
+    bool Update(EdgeId first_edge, EdgeId last_edge) override;
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    static constexpr Weight ZERO_WEIGHT{};
+
+    void CheckWeights(EdgeId first_edge, EdgeId last_edge) const {
+        for (EdgeId edge_id = first_edge; edge_id < last_edge; ++edge_id) {
+            if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    const Graph& source_graph_;
+    FrozenGraph<Weight> graph_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : source_graph_(graph)
+    , graph_(graph)
+{
+    CheckWeights(0, graph_.GetEdgeCount());
+}
+
+template <typename Weight>
+bool DijkstraRouter<Weight>::Update(EdgeId first_edge, EdgeId last_edge) {
+    graph_ = FrozenGraph<Weight>(source_graph_);
+    CheckWeights(first_edge, last_edge);
+    return true;
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    std::vector<std::optional<Weight>> weights(vertex_count);
+    std::vector<std::optional<EdgeId>> prev_edges(vertex_count);
+
+    Queue queue;
+    weights[from] = ZERO_WEIGHT;
+    queue.emplace(ZERO_WEIGHT, from);
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (*weights[vertex] < weight) {
+            // устаревшая запись очереди, вершина уже достигнута короче
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+        for (size_t position = graph_.GetIncidenceBegin(vertex); position < graph_.GetIncidenceEnd(vertex);
+             ++position) {
+            const VertexId target = graph_.GetTarget(position);
+            const Weight candidate_weight = weight + graph_.GetWeight(position);
+            auto& target_weight = weights[target];
+            if (!target_weight || candidate_weight < *target_weight) {
+                target_weight = candidate_weight;
+                prev_edges[target] = graph_.GetEdgeId(position);
+                queue.emplace(candidate_weight, target);
+            }
+        }
+    }
+
+    if (!weights[to]) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = prev_edges[to];
+         edge_id;
+         edge_id = prev_edges[graph_.GetEdge(*edge_id).from])
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{*weights[to], std::move(edges)};
+}
+
+}  // namespace graph
@@ -25,15 +25,14 @@ uint32_t RenderSettings::stopLabelFontSize() const {
 
 double RenderSettings::underlayerWidth() const { return underlayer_width_; }
 
-const svg::Color &RenderSettings::nextColor() const {
-  if (color_palette_.size() == paletteIndex_) {
-    paletteIndex_ = 0;
+const svg::Color &RenderSettings::paletteColor(size_t index) const {
+  // пустая палитра бывает только у неверных настроек
+  if (color_palette_.empty()) {
+    return svg::NoneColor;
   }
-  return color_palette_.at(paletteIndex_++);
+  return color_palette_.at(index % color_palette_.size());
 }
 
-void RenderSettings::resetColorPalette() const { paletteIndex_ = 0; }
-
 svg::Point RenderSettings::busLabelOffset() const { return bus_label_offset_; }
 
 svg::Point RenderSettings::stopLabelOffset() const {
@@ -195,20 +194,17 @@ ostream &operator<<(std::ostream &ostream, const RenderSettings &info) {
 } // namespace renderer
 
 /*--------------------------- StopStat --------------------------------------*/
-StopStat::StopStat(const std::string &name) : name(name) {}
-StopStat::StopStat(const std::string &name, const std::vector<string> &buses)
-    : name(name), buses(buses.begin(), buses.end()) {}
+StopStat::StopStat(string_view name) : name(name) {}
+StopStat::StopStat(string_view name, vector<string_view> buses)
+    : name(name), buses(move(buses)) {}
 /*--------------------------- BusStat ---------------------------------------*/
-BusStat::BusStat(const std::string &name) : name(/*std::string(name)*/ name) {}
+BusStat::BusStat(string_view name) : name(/*std::string(name)*/ name) {}
 
 /*--------------------------- BusQuery --------------------------------------*/
-BusData::BusData(const string &name) : name(name) {}
+BusData::BusData(string_view name) : name(name) {}
 
 /*--------------------------- StopQuery -------------------------------------*/
-StopData::StopData(const string &name) : name(name) {}
-
-/*--------------------------- BusInfo ---------------------------------------*/
-BusInfo::BusInfo(string_view name) : name(name) {}
+StopData::StopData(string_view name) : name(name) {}
 
 /*--------------------------- StopInfo --------------------------------------*/
 StopInfo::StopInfo(string_view name, detail::Coordinates coordinates)
@@ -11,6 +11,7 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <variant>
@@ -55,8 +56,9 @@ public:
   [[nodiscard]] svg::Point stopLabelOffset() const;
   [[nodiscard]] const svg::Color &underlayerColor() const;
   [[nodiscard]] double underlayerWidth() const;
-  [[nodiscard]] const svg::Color &nextColor() const;
-  void resetColorPalette() const;
+  // цвет палитры для маршрута с порядковым номером index (по кругу);
+  // NoneColor при пустой палитре
+  [[nodiscard]] const svg::Color &paletteColor(size_t index) const;
   [[nodiscard]] bool isValid() const;
   [[nodiscard]] operator bool() const;
   [[nodiscard]] operator std::string() const;
@@ -75,7 +77,6 @@ public:
 
 private:
   static const int MaxRenderSize = 100'000;
-  mutable size_t paletteIndex_{};
   double width_{}; // ширина изображения в пикселях. Вещественное число в
                    // диапазоне от 0 до 100000.
   double height_{}; // высота изображения в пикселях. Вещественное число в
@@ -117,22 +118,24 @@ private:
 
 
 
-// Запросы на добавление и на извлечение информации используют одну структуру
+// Запросы на добавление и на извлечение информации используют одну структуру.
+// Названия остановок и маршрутов - string_view в пул строк (string_pool.h)
 /* --------------- Структуры представляющие Остановку ----------------------- */
 struct StopData { // Входной запрос
   StopData() = default;
-  explicit StopData(const std::string & name);
-  std::string name{};
+  explicit StopData(std::string_view name);
+  std::string_view name{};
   detail::Coordinates coordinates{};
-  std::map<std::string, double> road_distances{};
+  std::map<std::string_view, double> road_distances{};
 };
 
 struct StopStat { // Результат со статистикой
   StopStat() = default;
-  explicit StopStat(const std::string & name);
-  explicit StopStat(const std::string & name, const std::vector<std::string> &);
-  std::string name{};
-  std::vector<std::string> buses{};
+  explicit StopStat(std::string_view name);
+  explicit StopStat(std::string_view name,
+                    std::vector<std::string_view> buses);
+  std::string_view name{};
+  std::vector<std::string_view> buses{};
 };
 
 struct StopInfo {
@@ -141,55 +144,31 @@ struct StopInfo {
   detail::Coordinates coordinates{};
 };
 
+struct StopDistance { // Измеренное расстояние между остановками
+  std::string_view from;
+  std::string_view to;
+  double distance;
+};
+
 /* --------------- Структуры представляющие Автобус ------------------------- */
 struct BusData { // Входной запрос
   BusData() = default;
-  explicit BusData(const std::string & name);
-  std::string name{};
-  std::vector<std::string> stops{};
+  explicit BusData(std::string_view name);
+  std::string_view name{};
+  std::vector<std::string_view> stops{};
   bool is_roundtrip{};
 };
 
 struct BusStat { // Результат со статистикой
   BusStat() = default;
-  explicit BusStat(const std::string &);
-  std::string name;
+  explicit BusStat(std::string_view);
+  std::string_view name;
   uint stops_count{};
   uint unique_stops_count {};
   double geolength {};
   double routelength {};
 };
 
-struct BusInfo {
-  explicit BusInfo(std::string_view name);
-  std::string_view name;
-  std::vector<StopInfo> stops;
-  bool is_roundtrip;
-};
-
-struct StopPair_hash {
-    template <typename T>
-    auto operator()(const std::pair<T, T>& pair) const {
-        return std::hash<T>{}(pair.first) ^ std::hash<T>{}(pair.second); // not to be used in production (combining hashes using XOR is bad practice)
-    }
-
-    using is_transparent = void; // required to make find() work with different type than key_type
-};
-
-struct StopPair_equal {
-    template <typename A, typename B>
-    auto operator()(const std::pair<A, A>& a,
-                    const std::pair<B, B>& b) const {
-        return a.first == b.first && a.second == b.second;
-    }
-
-    using is_transparent = void; // required to make find() work with different type than key_type
-};
-using StopPair =
-    std::pair<std::string_view , std::string_view >;
-using Distances =
-    std::unordered_map<StopPair, double, StopPair_hash, StopPair_equal>;
-
 /* --------------- Структуры представляющие карту --------------------------- */
 
 struct MapStat { // Результат со статистикой
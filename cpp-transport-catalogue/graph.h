@@ -3,6 +3,7 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <numeric>
 #include <vector>
 
 namespace graph {
@@ -26,7 +27,9 @@ private:
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
+    VertexId AddVertex();
     EdgeId AddEdge(const Edge<Weight>& edge);
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
@@ -43,6 +46,12 @@ DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
     : incidence_lists_(vertex_count) {
 }
 
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    incidence_lists_.emplace_back();
+    return incidence_lists_.size() - 1;
+}
+
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     edges_.push_back(edge);
@@ -51,6 +60,11 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     return id;
 }
 
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    edges_.at(edge_id).weight = weight;
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
@@ -71,4 +85,100 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+// Неизменяемое представление графа в формате CSR: исходящие рёбра вершины v
+// занимают позиции [GetIncidenceBegin(v), GetIncidenceEnd(v)) в непрерывных
+// массивах целей, весов и номеров рёбер. Порядок рёбер вершины совпадает с
+// порядком в DirectedWeightedGraph. Доступ без проверки границ.
+template <typename Weight>
+class FrozenGraph {
+public:
+    FrozenGraph() = default;
+    explicit FrozenGraph(const DirectedWeightedGraph<Weight>& graph);
+
+    size_t GetVertexCount() const;
+    size_t GetEdgeCount() const;
+    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+
+    size_t GetIncidenceBegin(VertexId vertex) const;
+    size_t GetIncidenceEnd(VertexId vertex) const;
+    VertexId GetTarget(size_t position) const;
+    Weight GetWeight(size_t position) const;
+    EdgeId GetEdgeId(size_t position) const;
+
+private:
+    std::vector<Edge<Weight>> edges_;
+    std::vector<size_t> offsets_;
+    std::vector<VertexId> targets_;
+    std::vector<Weight> weights_;
+    std::vector<EdgeId> edge_ids_;
+};
+
+template <typename Weight>
+FrozenGraph<Weight>::FrozenGraph(const DirectedWeightedGraph<Weight>& graph)
+    : offsets_(graph.GetVertexCount() + 1)
+    , targets_(graph.GetEdgeCount())
+    , weights_(graph.GetEdgeCount())
+    , edge_ids_(graph.GetEdgeCount()) {
+    const size_t vertex_count = graph.GetVertexCount();
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        const auto incident_edges = graph.GetIncidentEdges(vertex);
+        offsets_[vertex + 1] = static_cast<size_t>(std::distance(incident_edges.begin(), incident_edges.end()));
+    }
+    std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+    edges_.reserve(graph.GetEdgeCount());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        edges_.push_back(graph.GetEdge(edge_id));
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        size_t position = offsets_[vertex];
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            targets_[position] = edges_[edge_id].to;
+            weights_[position] = edges_[edge_id].weight;
+            edge_ids_[position] = edge_id;
+            ++position;
+        }
+    }
+}
+
+template <typename Weight>
+size_t FrozenGraph<Weight>::GetVertexCount() const {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
+
+template <typename Weight>
+size_t FrozenGraph<Weight>::GetEdgeCount() const {
+    return edges_.size();
+}
+
+template <typename Weight>
+const Edge<Weight>& FrozenGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    return edges_[edge_id];
+}
+
+template <typename Weight>
+size_t FrozenGraph<Weight>::GetIncidenceBegin(VertexId vertex) const {
+    return offsets_[vertex];
+}
+
+template <typename Weight>
+size_t FrozenGraph<Weight>::GetIncidenceEnd(VertexId vertex) const {
+    return offsets_[vertex + 1];
+}
+
+template <typename Weight>
+VertexId FrozenGraph<Weight>::GetTarget(size_t position) const {
+    return targets_[position];
+}
+
+template <typename Weight>
+Weight FrozenGraph<Weight>::GetWeight(size_t position) const {
+    return weights_[position];
+}
+
+template <typename Weight>
+EdgeId FrozenGraph<Weight>::GetEdgeId(size_t position) const {
+    return edge_ids_[position];
+}
 }  // namespace graph
\ No newline at end of file
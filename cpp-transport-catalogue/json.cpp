@@ -1,6 +1,10 @@
 #include "json.h"
+#include "json_scan.h"
 
-#include <iterator>
+#include <array>
+#include <charconv>
+#include <string_view>
+#include <utility>
 
 using namespace json;
 
@@ -19,43 +23,129 @@ inline constexpr const char *JSON_FALSE = "false";
 
 using namespace std::literals;
 
-Node LoadNode(std::istream &input);
-Node LoadString(std::istream &input);
+// Размер порции, которой читается поток при разборе
+inline constexpr size_t STREAM_CHUNK_SIZE = 1 << 16;
+
+// Разбор JSON из непрерывного буфера или из потока порциями: указатель на
+// текущий символ и конец порции. Буфер не обязан заканчиваться нулём
+// (например, отображённый в память файл). Разобранные значения передаются
+// обработчику событиями, дерево Node парсер не строит
+class Parser {
+public:
+  Parser(std::string_view input, Handler &handler)
+      : pos_(input.data()), end_(input.data() + input.size()),
+        handler_(handler) {}
+
+  Parser(std::istream &input, Handler &handler)
+      : input_(&input), chunk_(STREAM_CHUNK_SIZE, '\0'), pos_(chunk_.data()),
+        end_(chunk_.data()), handler_(handler) {}
+
+  void LoadNode();
+
+private:
+  // поток и буфер очередной порции; nullptr - разбирается весь буфер сразу
+  std::istream *input_ = nullptr;
+  std::string chunk_{};
+  // строка с экранированием или на стыке порций потока
+  std::string string_buffer_{};
+  // число на стыке порций потока
+  std::string number_buffer_{};
+  const char *pos_;
+  const char *end_;
+  Handler &handler_;
+
+  static bool IsDigit(char chr) { return chr >= '0' && chr <= '9'; }
+
+  static bool IsAlpha(char chr) {
+    return (chr >= 'a' && chr <= 'z') || (chr >= 'A' && chr <= 'Z');
+  }
 
-std::string LoadLiteral(std::istream &input) {
-  std::string str;
-  while (std::isalpha(input.peek()) != 0) {
-    str.push_back(static_cast<char>(input.get()));
+  // Читает следующую порцию потока. false - данных больше нет
+  bool Fill() {
+    if (input_ == nullptr || !*input_) {
+      return false;
+    }
+    input_->read(chunk_.data(), static_cast<std::streamsize>(chunk_.size()));
+    const auto count = static_cast<size_t>(input_->gcount());
+    pos_ = chunk_.data();
+    end_ = pos_ + count;
+    return count != 0;
   }
-  return str;
+
+  // Текущая порция разобрана и следующей нет
+  bool AtEnd() { return pos_ == end_ && !Fill(); }
+
+  // Пропускает пробельные символы и возвращает следующий символ (как
+  // input >> chr). false - достигнут конец данных
+  bool NextToken(char &chr) {
+    do {
+      pos_ = detail::SkipSpaces(pos_, end_);
+    } while (pos_ == end_ && Fill());
+    if (pos_ == end_) {
+      return false;
+    }
+    chr = *pos_++;
+    return true;
+  }
+
+  // Символ в текущей позиции без продвижения, '\0' в конце данных
+  char Peek() { return AtEnd() ? '\0' : *pos_; }
+
+  std::string LoadLiteral();
+  void LoadArray();
+  void LoadDict();
+  // Строка без экранирования - участок входа, иначе string_buffer_.
+  // Действительна до следующего разбора строки или чтения порции
+  std::string_view LoadString();
+  void LoadBool();
+  void LoadNull();
+  void LoadNumber();
+};
+
+std::string Parser::LoadLiteral() {
+  std::string literal;
+  while (IsAlpha(Peek())) {
+    literal.push_back(*pos_++);
+  }
+  return literal;
 }
 
-Node LoadArray(std::istream &input) {
-  std::vector<Node> result;
+void Parser::LoadArray() {
+  handler_.StartArray();
 
-  for (char chr = 0; input >> chr && chr != JSON_ARRAY_END;) {
+  char chr = 0;
+  bool closed = false;
+  while (NextToken(chr)) {
+    if (chr == JSON_ARRAY_END) {
+      closed = true;
+      break;
+    }
+    // только что прочитанный символ всегда в текущей порции
     if (chr != JSON_VALUE_SEPARATOR) {
-      input.putback(chr);
+      --pos_;
     }
-    result.push_back(LoadNode(input));
+    LoadNode();
   }
-  if (!input) {
+  if (!closed) {
     throw ParsingError("Array parsing error"s);
   }
-  return Node(std::move(result));
+  handler_.EndArray();
 }
 
-Node LoadDict(std::istream &input) {
-  Dict dict;
+void Parser::LoadDict() {
+  handler_.StartDict();
 
-  for (char chr = 0; input >> chr && chr != JSON_OBJECT_END;) {
+  char chr = 0;
+  bool closed = false;
+  while (NextToken(chr)) {
+    if (chr == JSON_OBJECT_END) {
+      closed = true;
+      break;
+    }
     if (chr == JSON_STRING_BEGIN) {
-      std::string key = LoadString(input).AsString();
-      if (input >> chr && chr == JSON_NAME_SEPARATOR) {
-        if (dict.find(key) != dict.end()) {
-          throw ParsingError("Duplicate key '"s + key + "' have been found");
-        }
-        dict.emplace(std::move(key), LoadNode(input));
+      handler_.Key(LoadString());
+      if (NextToken(chr) && chr == JSON_NAME_SEPARATOR) {
+        LoadNode();
       } else {
         throw ParsingError(": is expected but '"s + std::to_string(chr) +
                            "' has been found"s);
@@ -65,108 +155,129 @@ Node LoadDict(std::istream &input) {
                          "' has been found"s);
     }
   }
-  if (!input) {
+  if (!closed) {
     throw ParsingError("Dictionary parsing error"s);
   }
-  return Node(std::move(dict));
+  handler_.EndDict();
 }
 
-Node LoadString(std::istream &input) {
-  auto iter = std::istreambuf_iterator<char>(input);
-  auto end = std::istreambuf_iterator<char>();
-  std::string str;
+std::string_view Parser::LoadString() {
+  // обычно строка целиком лежит в текущей порции и её не нужно копировать
+  const char *begin = pos_;
+  pos_ = detail::FindStringSpecial(pos_, end_);
+  if (pos_ != end_ && *pos_ == JSON_STRING_END) {
+    return {begin, static_cast<size_t>(pos_++ - begin)};
+  }
+  pos_ = begin;
+  std::string &str = string_buffer_;
+  str.clear();
   while (true) {
-    if (iter == end) {
-      throw ParsingError("String parsing error");
+    // Участок без экранирования копируется целиком
+    const char *chunk = pos_;
+    pos_ = detail::FindStringSpecial(pos_, end_);
+    str.append(chunk, pos_);
+    if (pos_ == end_) {
+      // строка продолжается в следующей порции потока
+      if (!Fill()) {
+        throw ParsingError("String parsing error");
+      }
+      continue;
     }
-    const char chr = *iter;
-    if (chr == JSON_STRING_BEGIN) {
-      ++iter;
+    const char chr = *pos_++;
+    if (chr == JSON_STRING_END) {
       break;
     }
-    if (chr == '\\') {
-      ++iter;
-      if (iter == end) {
-        throw ParsingError("String parsing error");
-      }
-      const char escaped_char = *(iter);
-      switch (escaped_char) {
-      case 'n':
-        str.push_back('\n');
-        break;
-      case 't':
-        str.push_back('\t');
-        break;
-      case 'r':
-        str.push_back('\r');
-        break;
-      case JSON_STRING_BEGIN:
-        str.push_back(JSON_STRING_BEGIN);
-        break;
-      case '\\':
-        str.push_back('\\');
-        break;
-      default:
-        throw ParsingError("Unrecognized escape sequence \\"s +
-                           std::to_string(escaped_char));
-      }
-    } else if (chr == '\n' || chr == '\r') {
+    if (chr == '\n' || chr == '\r') {
       throw ParsingError("Unexpected end of line"s);
-    } else {
-      str.push_back(chr);
     }
-    ++iter;
+    if (AtEnd()) {
+      throw ParsingError("String parsing error");
+    }
+    const char escaped_char = *pos_++;
+    switch (escaped_char) {
+    case 'n':
+      str.push_back('\n');
+      break;
+    case 't':
+      str.push_back('\t');
+      break;
+    case 'r':
+      str.push_back('\r');
+      break;
+    case JSON_STRING_BEGIN:
+      str.push_back(JSON_STRING_BEGIN);
+      break;
+    case '\\':
+      str.push_back('\\');
+      break;
+    default:
+      throw ParsingError("Unrecognized escape sequence \\"s +
+                         std::to_string(escaped_char));
+    }
   }
-
-  return Node(std::move(str));
+  return str;
 }
 
-Node LoadBool(std::istream &input) {
-  const auto str = LoadLiteral(input);
+void Parser::LoadBool() {
+  const auto str = LoadLiteral();
   if (str == JSON_TRUE) {
-    return Node{true};
+    handler_.Value(true);
+    return;
   }
   if (str == JSON_FALSE) {
-    return Node{false};
+    handler_.Value(false);
+    return;
   }
   throw ParsingError("Failed to parse '"s + str + "' as bool"s);
 }
 
-Node LoadNull(std::istream &input) {
-  auto literal = LoadLiteral(input);
+void Parser::LoadNull() {
+  const auto literal = LoadLiteral();
   if (literal == JSON_NULL) {
-    return Node{nullptr};
+    handler_.Value(nullptr);
+    return;
   }
   throw ParsingError("Failed to parse '"s + literal + "' as null"s);
 }
 
-Node LoadNumber(std::istream &input) {
-  std::string parsed_num;
+void Parser::LoadNumber() {
+  // число обычно целиком лежит в текущей порции и преобразуется прямо из неё.
+  // На стыке порций потока прочитанная часть переносится в number_buffer_
+  const char *begin = pos_;
+  bool spilled = false;
 
-  // Считывает в parsed_num очередной символ из input
-  auto read_char = [&parsed_num, &input] {
-    parsed_num += static_cast<char>(input.get());
-    if (!input) {
-      throw ParsingError("Failed to read number from stream"s);
+  // Символ в текущей позиции, как Peek; перед чтением следующей порции
+  // сохраняет прочитанную часть числа
+  auto peek = [this, &begin, &spilled] {
+    if (pos_ != end_) {
+      return *pos_;
+    }
+    if (!spilled) {
+      number_buffer_.clear();
+      spilled = true;
     }
+    number_buffer_.append(begin, pos_);
+    const char chr = Peek();
+    begin = pos_;
+    return chr;
   };
 
-  // Считывает одну или более цифр в parsed_num из input
-  auto read_digits = [&input, read_char] {
-    if (!std::isdigit(input.peek())) {
+  // Переносит одну или более цифр
+  auto read_digits = [this, &peek] {
+    if (!IsDigit(peek())) {
       throw ParsingError("A digit is expected"s);
     }
-    while (std::isdigit(input.peek())) {
-      read_char();
+    while (IsDigit(peek())) {
+      ++pos_;
     }
   };
 
-  if (input.peek() == '-') {
-    read_char();
+  if (peek() == '-') {
+    ++pos_;
   }
   // Парсим целую часть числа
-  if (input.peek() == '0') {
-    read_char();
+  if (peek() == '0') {
+    ++pos_;
     // После 0 в JSON не могут идти другие цифры
   } else {
     read_digits();
@@ -174,50 +285,63 @@ Node LoadNumber(std::istream &input) {
 
   bool is_int = true;
   // Парсим дробную часть числа
-  if (input.peek() == '.') {
-    read_char();
+  if (peek() == '.') {
+    ++pos_;
     read_digits();
     is_int = false;
   }
 
   // Парсим экспоненциальную часть числа
-  if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-    read_char();
-    if (ch = input.peek(); ch == '+' || ch == '-') {
-      read_char();
+  if (char chr = peek(); chr == 'e' || chr == 'E') {
+    ++pos_;
+    if (chr = peek(); chr == '+' || chr == '-') {
+      ++pos_;
     }
     read_digits();
     is_int = false;
   }
 
-  try {
-    if (is_int) {
-      // Сначала пробуем преобразовать строку в int
-      try {
-        return std::stoi(parsed_num);
-      } catch (...) {
-        // В случае неудачи, например, при переполнении
-        // код ниже попробует преобразовать строку в double
-      }
+  std::string_view number(begin, static_cast<size_t>(pos_ - begin));
+  if (spilled) {
+    number_buffer_.append(number);
+    number = number_buffer_;
+  }
+  const char *first = number.data();
+  const char *last = first + number.size();
+  if (is_int) {
+    // Сначала пробуем преобразовать строку в int. При переполнении
+    // код ниже преобразует строку в double
+    int value = 0;
+    if (const auto [ptr, error] = std::from_chars(first, last, value);
+        error == std::errc{} && ptr == last) {
+      handler_.Value(value);
+      return;
     }
-    return std::stod(parsed_num);
-  } catch (...) {
-    throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
   }
+  double value = 0;
+  if (const auto [ptr, error] = std::from_chars(first, last, value);
+      error != std::errc{} || ptr != last) {
+    throw ParsingError("Failed to convert "s + std::string(number) +
+                       " to number"s);
+  }
+  handler_.Value(value);
 }
 
-Node LoadNode(std::istream &input) {
+void Parser::LoadNode() {
   char chr = 0;
-  if (!(input >> chr)) {
+  if (!NextToken(chr)) {
     throw ParsingError("Unexpected EOF"s);
   }
   switch (chr) {
   case JSON_ARRAY_BEGIN:
-    return LoadArray(input);
+    LoadArray();
+    return;
   case JSON_OBJECT_BEGIN:
-    return LoadDict(input);
+    LoadDict();
+    return;
   case JSON_STRING_BEGIN:
-    return LoadString(input);
+    handler_.Value(LoadString());
+    return;
   case 't':
     // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
     // подсказкой компилятору и человеку, что здесь программист явно задумывал
@@ -227,15 +351,18 @@ Node LoadNode(std::istream &input) {
     // литералов true либо false
     [[fallthrough]];
   case 'f':
-    input.putback(chr);
-    return LoadBool(input);
+    --pos_;
+    LoadBool();
+    return;
   case 'n':
-    input.putback(chr);
-    return LoadNull(input);
+    --pos_;
+    LoadNull();
+    return;
   default:
-    if ((0 != std::isdigit(chr)) || '-' == chr) {
-      input.putback(chr);
-      return LoadNumber(input);
+    if (IsDigit(chr) || '-' == chr) {
+      --pos_;
+      LoadNumber();
+      return;
     }
   }
   throw ParsingError("Unkown symbol \""s + chr + "(" + std::to_string(chr) +
@@ -265,9 +392,19 @@ void PrintValue(const Value &value, PrintContext ctx) {
   ctx.out << value;
 }
 
-void PrintString(const std::string &value, std::ostream &out) {
+void PrintString(std::string_view value, std::ostream &out) {
   out.put(JSON_STRING_BEGIN);
-  for (const char chr : value) {
+  // Участки без экранируемых символов выводятся целиком
+  const char *chunk = value.data();
+  const char *const end = value.data() + value.size();
+  for (const char *iter = chunk; iter != end; ++iter) {
+    const char chr = *iter;
+    if (chr != '\r' && chr != '\n' && chr != JSON_STRING_BEGIN &&
+        chr != '\\') {
+      continue;
+    }
+    out.write(chunk, iter - chunk);
+    chunk = iter + 1;
     switch (chr) {
     case '\r':
       out << "\\r"sv;
@@ -275,20 +412,38 @@ void PrintString(const std::string &value, std::ostream &out) {
     case '\n':
       out << "\\n"sv;
       break;
-    case JSON_STRING_BEGIN:
+    default:
       // Символы " и \ выводятся как \" или \\, соответственно
-      [[fallthrough]];
-    case '\\':
       out.put('\\');
-      [[fallthrough]];
-    default:
       out.put(chr);
       break;
     }
   }
+  out.write(chunk, end - chunk);
   out.put(JSON_STRING_END);
 }
 
+// Числа выводятся без учёта локали: целые - to_chars, вещественные -
+// кратчайшей записью, которая читается обратно в то же значение
+template <typename Number> void PrintNumber(Number value, std::ostream &out) {
+  std::array<char, 32> buffer{};
+  const auto [ptr, error] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+  out.write(buffer.data(), ptr - buffer.data());
+}
+
+template <> void PrintValue<int>(const int &value, PrintContext ctx) {
+  PrintNumber(value, ctx.out);
+}
+
+template <> void PrintValue<uint>(const uint &value, PrintContext ctx) {
+  PrintNumber(value, ctx.out);
+}
+
+template <> void PrintValue<double>(const double &value, PrintContext ctx) {
+  PrintNumber(value, ctx.out);
+}
+
 template <>
 void PrintValue<std::string>(const std::string &value, PrintContext ctx) {
   PrintString(value, ctx.out);
@@ -355,8 +510,74 @@ void PrintNode(const Node &node, const PrintContext &ctx) {
 
 } // namespace
 
+void json::Parse(std::string_view input, Handler &handler) {
+  Parser(input, handler).LoadNode();
+}
+
+void json::Parse(std::istream &input, Handler &handler) {
+  Parser(input, handler).LoadNode();
+  // поток читается порциями до конца: остаётся только признак eof
+  input.clear(input.rdstate() & ~std::ios::failbit);
+}
+
+json::Document json::Load(std::string_view input) {
+  NodeBuilder builder;
+  Parse(input, builder);
+  return Document{builder.Extract()};
+}
+
 json::Document json::Load(std::istream &input) {
-  return Document{LoadNode(input)};
+  NodeBuilder builder;
+  Parse(input, builder);
+  return Document{builder.Extract()};
+}
+
+void NodeBuilder::StartDict() { Open(Dict{}); }
+
+void NodeBuilder::Key(std::string_view key) { key_ = key; }
+
+void NodeBuilder::EndDict() { stack_.pop_back(); }
+
+void NodeBuilder::StartArray() { Open(Array{}); }
+
+void NodeBuilder::EndArray() { stack_.pop_back(); }
+
+void NodeBuilder::Value(std::nullptr_t value) { Put(Node{value}); }
+
+void NodeBuilder::Value(bool value) { Put(Node{value}); }
+
+void NodeBuilder::Value(int value) { Put(Node{value}); }
+
+void NodeBuilder::Value(double value) { Put(Node{value}); }
+
+void NodeBuilder::Value(std::string_view value) {
+  Put(Node{std::string(value)});
+}
+
+Node NodeBuilder::Extract() {
+  stack_.clear();
+  return std::exchange(root_, Node{});
+}
+
+Node *NodeBuilder::Put(Node value) {
+  if (stack_.empty()) {
+    root_ = std::move(value);
+    return &root_;
+  }
+  Node &container = *stack_.back();
+  if (container.IsArray()) {
+    return &container.AsArray().emplace_back(std::move(value));
+  }
+  auto [iter, inserted] =
+      container.AsDict().try_emplace(std::move(key_), std::move(value));
+  if (!inserted) {
+    throw ParsingError("Duplicate key '"s + iter->first + "' have been found");
+  }
+  return &iter->second;
+}
+
+void NodeBuilder::Open(Node container) {
+  stack_.push_back(Put(std::move(container)));
 }
 
 void json::Print(const Document &doc, std::ostream &output) {
@@ -368,6 +589,118 @@ std::ostream &json::operator<<(std::ostream &stream, const Node &node) {
   return stream;
 }
 
+/*------------------------------ Writer -----------------------------------*/
+Writer::Writer(std::ostream &output, int indent_step)
+    : output_(output), indent_step_(indent_step) {}
+
+Writer &Writer::StartDict() {
+  BeforeValue();
+  output_ << JSON_OBJECT_BEGIN << "\n"sv;
+  stack_.push_back({true, true});
+  return *this;
+}
+
+Writer &Writer::Key(std::string_view key) {
+  Level &level = stack_.back();
+  if (!level.first) {
+    output_ << JSON_VALUE_SEPARATOR << "\n"sv;
+  }
+  level.first = false;
+  PrintIndent();
+  PrintString(key, output_);
+  output_ << JSON_NAME_SEPARATOR << " "sv;
+  return *this;
+}
+
+Writer &Writer::EndDict() {
+  Close(true, JSON_OBJECT_END);
+  return *this;
+}
+
+Writer &Writer::StartArray() {
+  BeforeValue();
+  output_ << JSON_ARRAY_BEGIN << "\n"sv;
+  stack_.push_back({false, true});
+  return *this;
+}
+
+Writer &Writer::EndArray() {
+  Close(false, JSON_ARRAY_END);
+  return *this;
+}
+
+Writer &Writer::Value(std::nullptr_t /*unused*/) {
+  BeforeValue();
+  output_ << JSON_NULL;
+  return *this;
+}
+
+Writer &Writer::Value(bool value) {
+  BeforeValue();
+  output_ << (value ? JSON_TRUE : JSON_FALSE);
+  return *this;
+}
+
+Writer &Writer::Value(int value) {
+  BeforeValue();
+  PrintNumber(value, output_);
+  return *this;
+}
+
+Writer &Writer::Value(uint value) {
+  BeforeValue();
+  PrintNumber(value, output_);
+  return *this;
+}
+
+Writer &Writer::Value(double value) {
+  BeforeValue();
+  PrintNumber(value, output_);
+  return *this;
+}
+
+Writer &Writer::Value(std::string_view value) {
+  BeforeValue();
+  PrintString(value, output_);
+  return *this;
+}
+
+Writer &Writer::Value(const char *value) {
+  return Value(std::string_view(value));
+}
+
+bool Writer::IsOpen() const { return !stack_.empty(); }
+
+void Writer::BeforeValue() {
+  // значение словаря пишется сразу после ключа
+  if (stack_.empty() || stack_.back().is_dict) {
+    return;
+  }
+  if (!stack_.back().first) {
+    output_ << JSON_VALUE_SEPARATOR << "\n"sv;
+  }
+  stack_.back().first = false;
+  PrintIndent();
+}
+
+void Writer::PrintIndent() {
+  for (size_t i = 0; i < stack_.size() * static_cast<size_t>(indent_step_);
+       ++i) {
+    output_.put(' ');
+  }
+}
+
+void Writer::Close(bool is_dict, char end) {
+  if (stack_.empty() || stack_.back().is_dict != is_dict) {
+    throw std::logic_error("Unbalanced end of "s +
+                           (is_dict ? "dict"s : "array"s));
+  }
+  stack_.pop_back();
+  output_.put('\n');
+  PrintIndent();
+  output_.put(end);
+}
+
 bool Node::IsInt() const { return std::holds_alternative<int>(*this); }
 
 int Node::AsInt() const {
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -99,9 +100,113 @@ inline bool operator!=(const Document &lhs, const Document &rhs) {
   return !(lhs == rhs);
 }
 
+// Обработчик событий потокового (SAX) разбора. Ключ словаря передаётся через
+// Key перед своим значением, скалярные значения - через Value. Ключи и строки
+// ссылаются на вход или буфер парсера и действительны только во время вызова
+class Handler {
+public:
+  Handler() = default;
+  Handler(const Handler &other) = delete;
+  Handler(Handler &&other) = delete;
+  Handler &operator=(const Handler &other) = delete;
+  Handler &operator=(Handler &&other) = delete;
+  virtual ~Handler() = default;
+
+  virtual void StartDict() = 0;
+  virtual void Key(std::string_view key) = 0;
+  virtual void EndDict() = 0;
+  virtual void StartArray() = 0;
+  virtual void EndArray() = 0;
+  virtual void Value(std::nullptr_t value) = 0;
+  virtual void Value(bool value) = 0;
+  virtual void Value(int value) = 0;
+  virtual void Value(double value) = 0;
+  virtual void Value(std::string_view value) = 0;
+};
+
+// Обработчик, строящий дерево Node из событий разбора. При повторе ключа в
+// словаре бросается ParsingError
+class NodeBuilder final : public Handler {
+public:
+  NodeBuilder() = default;
+
+  void StartDict() override;
+  void Key(std::string_view key) override;
+  void EndDict() override;
+  void StartArray() override;
+  void EndArray() override;
+  void Value(std::nullptr_t value) override;
+  void Value(bool value) override;
+  void Value(int value) override;
+  void Value(double value) override;
+  void Value(std::string_view value) override;
+
+  // Забирает построенное значение, после чего можно строить следующее
+  Node Extract();
+
+private:
+  Node root_{};
+  // незакрытые словари и массивы от корня к текущему
+  std::vector<Node *> stack_{};
+  std::string key_{};
+
+  Node *Put(Node value);
+  void Open(Node container);
+};
+
+// Разбирает одно значение из непрерывного буфера, передавая события handler
+void Parse(std::string_view input, Handler &handler);
+
+// Разбирает одно значение, читая поток порциями фиксированного размера
+void Parse(std::istream &input, Handler &handler);
+
+// Разбор документа из непрерывного буфера
+Document Load(std::string_view input);
+
+// Разбор документа из потока
 Document Load(std::istream &input);
 
 void Print(const Document &doc, std::ostream &output);
 
+// Потоковая запись JSON в том же виде, что и Print, без построения дерева
+// Node: значения пишутся в поток по мере вызовов. Ключи словаря выводятся в
+// порядке вызовов Key
+class Writer {
+public:
+  explicit Writer(std::ostream &output, int indent_step = 4);
+
+  Writer &StartDict();
+  Writer &Key(std::string_view key);
+  Writer &EndDict();
+  Writer &StartArray();
+  Writer &EndArray();
+
+  Writer &Value(std::nullptr_t value);
+  Writer &Value(bool value);
+  Writer &Value(int value);
+  Writer &Value(uint value);
+  Writer &Value(double value);
+  Writer &Value(std::string_view value);
+  // без этой перегрузки строковый литерал преобразовался бы в bool
+  Writer &Value(const char *value);
+
+  // Открыт хотя бы один словарь или массив
+  [[nodiscard]] bool IsOpen() const;
+
+private:
+  // открытый контейнер и признак того, что в нём ещё нет элементов
+  struct Level {
+    bool is_dict;
+    bool first;
+  };
+  std::ostream &output_;
+  int indent_step_;
+  std::vector<Level> stack_{};
+
+  void BeforeValue();
+  void PrintIndent();
+  void Close(bool is_dict, char end);
+};
+
 std::ostream &operator<<(std::ostream &stream, const Node &node);
 } // namespace json
@@ -0,0 +1,240 @@
+#include "json_arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace json::arena;
+
+namespace {
+// размер первого блока арены; следующие вдвое больше предыдущего
+inline constexpr size_t ARENA_FIRST_BLOCK_SIZE = size_t{1} << 16;
+inline constexpr size_t ARENA_MAX_BLOCK_SIZE = size_t{1} << 26;
+
+size_t AlignUp(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+/*------------------------------ Arena ------------------------------------*/
+void *Arena::Allocate(size_t size, size_t alignment) {
+  while (current_ < blocks_.size()) {
+    Block &block = blocks_[current_];
+    if (const size_t offset = AlignUp(used_, alignment);
+        offset + size <= block.size) {
+      used_ = offset + size;
+      return block.data.get() + offset;
+    }
+    // оставшиеся блоки от прошлых значений тоже используются
+    ++current_;
+    used_ = 0;
+  }
+  const size_t previous = blocks_.empty() ? 0 : blocks_.back().size;
+  const size_t block_size =
+      max({ARENA_FIRST_BLOCK_SIZE, min(previous * 2, ARENA_MAX_BLOCK_SIZE),
+           size});
+  blocks_.push_back({make_unique<std::byte[]>(block_size), block_size});
+  current_ = blocks_.size() - 1;
+  // начало блока выровнено operator new для любого фундаментального типа
+  used_ = size;
+  return blocks_.back().data.get();
+}
+
+string_view Arena::CopyString(string_view str) {
+  if (str.empty()) {
+    return {};
+  }
+  auto *chars = AllocateArray<char>(str.size());
+  memcpy(chars, str.data(), str.size());
+  return {chars, str.size()};
+}
+
+void Arena::Clear() {
+  current_ = 0;
+  used_ = 0;
+}
+
+/*------------------------------ Views ------------------------------------*/
+const Node &ArrayView::at(size_t index) const {
+  if (index >= size_) {
+    throw out_of_range("Array index out of range"s);
+  }
+  return begin_[index];
+}
+
+const Member *DictView::find(string_view key) const {
+  const Member *iter =
+      lower_bound(begin(), end(), key, [](const Member &member, string_view k) {
+        return member.first < k;
+      });
+  return iter != end() && iter->first == key ? iter : end();
+}
+
+/*------------------------------- Node ------------------------------------*/
+Node::Node(bool value) : type_(Type::BOOL) { value_.bool_value = value; }
+
+Node::Node(int value) : type_(Type::INT) { value_.int_value = value; }
+
+Node::Node(double value) : type_(Type::DOUBLE) {
+  value_.double_value = value;
+}
+
+Node Node::String(string_view str) {
+  Node node;
+  node.type_ = Type::STRING;
+  node.size_ = static_cast<uint32_t>(str.size());
+  node.value_.chars = str.data();
+  return node;
+}
+
+Node Node::Array(const Node *items, size_t size) {
+  Node node;
+  node.type_ = Type::ARRAY;
+  node.size_ = static_cast<uint32_t>(size);
+  node.value_.items = items;
+  return node;
+}
+
+Node Node::Dict(const Member *members, size_t size) {
+  Node node;
+  node.type_ = Type::DICT;
+  node.size_ = static_cast<uint32_t>(size);
+  node.value_.members = members;
+  return node;
+}
+
+bool Node::AsBool() const {
+  if (!IsBool()) {
+    throw logic_error("Not a bool"s);
+  }
+  return value_.bool_value;
+}
+
+int Node::AsInt() const {
+  if (!IsInt()) {
+    throw logic_error("Not an int"s);
+  }
+  return value_.int_value;
+}
+
+double Node::AsDouble() const {
+  if (!IsDouble()) {
+    throw logic_error("Not a double"s);
+  }
+  return IsPureDouble() ? value_.double_value : value_.int_value;
+}
+
+string_view Node::AsString() const {
+  if (!IsString()) {
+    throw logic_error("Not a string"s);
+  }
+  return {value_.chars, size_};
+}
+
+ArrayView Node::AsArray() const {
+  if (!IsArray()) {
+    throw logic_error("Not an array"s);
+  }
+  return {value_.items, size_};
+}
+
+DictView Node::AsDict() const {
+  if (!IsDict()) {
+    throw logic_error("Not a dict"s);
+  }
+  return {value_.members, size_};
+}
+
+/*------------------------------ Builder ----------------------------------*/
+void Builder::StartDict() {
+  stack_.push_back({true, members_.size(), key_});
+}
+
+void Builder::Key(std::string_view key) { key_ = arena_.CopyString(key); }
+
+void Builder::EndDict() {
+  const Frame frame = stack_.back();
+  stack_.pop_back();
+  const auto first = members_.begin() + static_cast<ptrdiff_t>(frame.first_child);
+  stable_sort(first, members_.end(), [](const Member &lhs, const Member &rhs) {
+    return lhs.first < rhs.first;
+  });
+  if (const auto iter = adjacent_find(first, members_.end(),
+                                      [](const Member &lhs, const Member &rhs) {
+                                        return lhs.first == rhs.first;
+                                      });
+      iter != members_.end()) {
+    throw ParsingError("Duplicate key '"s + string(iter->first) +
+                       "' have been found");
+  }
+  const size_t size = members_.size() - frame.first_child;
+  auto *members = arena_.AllocateArray<Member>(size);
+  uninitialized_copy(first, members_.end(), members);
+  members_.erase(first, members_.end());
+  Put(Node::Dict(members, size), frame.key);
+}
+
+void Builder::StartArray() {
+  stack_.push_back({false, items_.size(), key_});
+}
+
+void Builder::EndArray() {
+  const Frame frame = stack_.back();
+  stack_.pop_back();
+  const auto first = items_.begin() + static_cast<ptrdiff_t>(frame.first_child);
+  const size_t size = items_.size() - frame.first_child;
+  auto *items = arena_.AllocateArray<Node>(size);
+  uninitialized_copy(first, items_.end(), items);
+  items_.erase(first, items_.end());
+  Put(Node::Array(items, size), frame.key);
+}
+
+void Builder::Value(std::nullptr_t /*value*/) { Put(Node{}, key_); }
+
+void Builder::Value(bool value) { Put(Node(value), key_); }
+
+void Builder::Value(int value) { Put(Node(value), key_); }
+
+void Builder::Value(double value) { Put(Node(value), key_); }
+
+void Builder::Value(std::string_view value) {
+  Put(Node::String(arena_.CopyString(value)), key_);
+}
+
+void Builder::Put(Node value, string_view key) {
+  if (stack_.empty()) {
+    root_ = value;
+  } else if (stack_.back().is_dict) {
+    members_.emplace_back(key, value);
+  } else {
+    items_.push_back(value);
+  }
+}
+
+Document Builder::Extract() {
+  Document document(std::move(arena_), root_);
+  Clear();
+  return document;
+}
+
+void Builder::Clear() {
+  arena_.Clear();
+  root_ = Node{};
+  stack_.clear();
+  items_.clear();
+  members_.clear();
+  key_ = {};
+}
+
+Document json::arena::Load(string_view input) {
+  Builder builder;
+  Parse(input, builder);
+  return builder.Extract();
+}
+
+Document json::arena::Load(istream &input) {
+  Builder builder;
+  Parse(input, builder);
+  return builder.Extract();
+}
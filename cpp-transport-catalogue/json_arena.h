@@ -0,0 +1,199 @@
+#pragma once
+
+#include "json.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Компактное представление JSON-документа. Узлы, ключи и строки размещаются в
+// монотонном буфере (арене), которым владеет документ; словари -
+// отсортированные по ключу массивы пар, строки - string_view в арену. Все типы
+// тривиально разрушаемы, поэтому документ освобождается блоками арены, без
+// обхода узлов
+
+namespace json::arena {
+
+// Монотонный буфер: память выделяется блоками растущего размера и
+// освобождается только целиком. Clear оставляет блоки для повторного
+// использования
+class Arena {
+public:
+  Arena() = default;
+  Arena(const Arena &other) = delete;
+  Arena(Arena &&other) noexcept = default;
+  Arena &operator=(const Arena &other) = delete;
+  Arena &operator=(Arena &&other) noexcept = default;
+  ~Arena() = default;
+
+  void *Allocate(size_t size, size_t alignment);
+
+  template <typename Type> Type *AllocateArray(size_t count) {
+    return static_cast<Type *>(
+        Allocate(sizeof(Type) * count, alignof(Type)));
+  }
+
+  std::string_view CopyString(std::string_view str);
+
+  void Clear();
+
+private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+  };
+  std::vector<Block> blocks_{};
+  // текущий блок и занятая в нём часть
+  size_t current_ = 0;
+  size_t used_ = 0;
+};
+
+class Node;
+class ArrayView;
+class DictView;
+using Member = std::pair<std::string_view, Node>;
+
+// Узел документа: тип, длина и значение либо указатель в арену (16 байт)
+class Node {
+public:
+  enum class Type : std::uint8_t { NUL, BOOL, INT, DOUBLE, STRING, ARRAY, DICT };
+
+  Node() = default;
+  explicit Node(bool value);
+  explicit Node(int value);
+  explicit Node(double value);
+  // строки, массивы и словари ссылаются на память арены
+  static Node String(std::string_view str);
+  static Node Array(const Node *items, size_t size);
+  static Node Dict(const Member *members, size_t size);
+
+  [[nodiscard]] Type GetType() const { return type_; }
+
+  [[nodiscard]] bool IsNull() const { return type_ == Type::NUL; }
+  [[nodiscard]] bool IsBool() const { return type_ == Type::BOOL; }
+  [[nodiscard]] bool AsBool() const;
+  [[nodiscard]] bool IsInt() const { return type_ == Type::INT; }
+  [[nodiscard]] int AsInt() const;
+  [[nodiscard]] bool IsPureDouble() const { return type_ == Type::DOUBLE; }
+  [[nodiscard]] bool IsDouble() const { return IsInt() || IsPureDouble(); }
+  [[nodiscard]] double AsDouble() const;
+  [[nodiscard]] bool IsString() const { return type_ == Type::STRING; }
+  [[nodiscard]] std::string_view AsString() const;
+  [[nodiscard]] bool IsArray() const { return type_ == Type::ARRAY; }
+  [[nodiscard]] ArrayView AsArray() const;
+  [[nodiscard]] bool IsDict() const { return type_ == Type::DICT; }
+  [[nodiscard]] DictView AsDict() const;
+
+private:
+  Type type_{Type::NUL};
+  // длина строки, число элементов массива или пар словаря
+  std::uint32_t size_{};
+  union {
+    bool bool_value;
+    int int_value;
+    double double_value;
+    const char *chars;
+    const Node *items;
+    const Member *members;
+  } value_{};
+};
+
+// Представления массива и словаря: непрерывные участки арены
+class ArrayView {
+public:
+  ArrayView(const Node *begin, size_t size) : begin_(begin), size_(size) {}
+  [[nodiscard]] const Node *begin() const { return begin_; }
+  [[nodiscard]] const Node *end() const { return begin_ + size_; }
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+  [[nodiscard]] const Node &at(size_t index) const;
+
+private:
+  const Node *begin_;
+  size_t size_;
+};
+
+class DictView {
+public:
+  DictView(const Member *begin, size_t size) : begin_(begin), size_(size) {}
+  [[nodiscard]] const Member *begin() const { return begin_; }
+  [[nodiscard]] const Member *end() const { return begin_ + size_; }
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+  // Двоичный поиск по ключу, end() - ключа нет
+  [[nodiscard]] const Member *find(std::string_view key) const;
+
+private:
+  const Member *begin_;
+  size_t size_;
+};
+
+// Документ владеет ареной со всеми своими узлами
+class Document {
+public:
+  Document() = default;
+  Document(Arena arena, Node root)
+      : arena_(std::move(arena)), root_(root) {}
+
+  [[nodiscard]] const Node &GetRoot() const { return root_; }
+
+private:
+  Arena arena_{};
+  Node root_{};
+};
+
+// Обработчик событий разбора, строящий узлы в арене. Дочерние узлы
+// незакрытых контейнеров накапливаются в переиспользуемых буферах и
+// переносятся в арену одним блоком при закрытии контейнера. Ключи и строки
+// копируются в арену один раз, прямо из входа или буфера парсера. При повторе
+// ключа в словаре бросается ParsingError
+class Builder final : public Handler {
+public:
+  Builder() = default;
+
+  void StartDict() override;
+  void Key(std::string_view key) override;
+  void EndDict() override;
+  void StartArray() override;
+  void EndArray() override;
+  void Value(std::nullptr_t value) override;
+  void Value(bool value) override;
+  void Value(int value) override;
+  void Value(double value) override;
+  void Value(std::string_view value) override;
+
+  // Построенное значение; действительно до Clear или Extract
+  [[nodiscard]] const Node &GetRoot() const { return root_; }
+  // Забирает документ вместе с ареной
+  Document Extract();
+  // Освобождает узлы, оставляя память арены для следующего значения
+  void Clear();
+
+private:
+  // незакрытый контейнер: начало его детей в items_ или members_ и ключ, под
+  // которым он будет добавлен в родительский словарь
+  struct Frame {
+    bool is_dict;
+    size_t first_child;
+    std::string_view key;
+  };
+
+  Arena arena_{};
+  Node root_{};
+  std::vector<Frame> stack_{};
+  std::vector<Node> items_{};
+  std::vector<Member> members_{};
+  std::string_view key_{};
+
+  void Put(Node value, std::string_view key);
+};
+
+// Разбор документа из непрерывного буфера
+Document Load(std::string_view input);
+
+// Разбор документа из потока
+Document Load(std::istream &input);
+
+} // namespace json::arena
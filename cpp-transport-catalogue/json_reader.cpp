@@ -1,8 +1,9 @@
 #include "json_reader.h"
-#include "json_builder.h"
+#include "json_arena.h"
 #include <algorithm>
 #include <limits>
 #include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -19,6 +20,7 @@ inline constexpr const char *ERROR_MESSAGE = "not found";
 inline constexpr const char *BASE_REQUESTS = "base_requests";
 inline constexpr const char *RENDER_SETTTINGS = "render_settings";
 inline constexpr const char *ROUTING_SETTINGS = "routing_settings";
+inline constexpr const char *SERIALIZATION_SETTINGS = "serialization_settings";
 inline constexpr const char *STAT_REQUESTS = "stat_requests";
 
 // Названия полей. Общее для многих разделов
@@ -55,17 +57,41 @@ inline constexpr const char *RENDER_SETTINGS_COLOR_PALETTE = "color_palette";
 // Названия полей. Раздел routing_settings
 inline constexpr const char *ROUTING_SETTINGS_BUS_WAIT = "bus_wait_time";
 inline constexpr const char *ROUTING_SETTINGS_BUS_VELOCITY = "bus_velocity";
+inline constexpr const char *ROUTING_SETTINGS_ROUTER_MODE = "router_mode";
+inline constexpr const char *ROUTING_SETTINGS_GRAPH_MODEL = "graph_model";
+inline constexpr const char *ROUTING_SETTINGS_ROUTER_FILE = "router_file";
+
+// Значения поля router_mode
+inline constexpr const char *ROUTER_MODE_PRECOMPUTED = "precomputed";
+inline constexpr const char *ROUTER_MODE_PRECOMPUTED_COMPACT =
+    "precomputed_compact";
+inline constexpr const char *ROUTER_MODE_ON_DEMAND = "on_demand";
+inline constexpr const char *ROUTER_MODE_CONTRACTION_HIERARCHY =
+    "contraction_hierarchy";
+
+// Значения поля graph_model
+inline constexpr const char *GRAPH_MODEL_STOP_TO_STOP = "stop_to_stop";
+inline constexpr const char *GRAPH_MODEL_RIDE_VERTICES = "ride_vertices";
+
+// Названия полей. Раздел serialization_settings
+inline constexpr const char *SERIALIZATION_SETTINGS_FILE = "file";
 
 // Названия полей. Раздел stat_requests
 inline constexpr const char *JSON_REQUEST_ID = "id";
 // Названия полей. Раздел stat_requests_Route
 inline constexpr const char *STATS_ROUTE_STOP_FROM = "from";
 inline constexpr const char *STATS_ROUTE_STOP_TO = "to";
+// Названия полей. Раздел stat_requests_Tile
+inline constexpr const char *STATS_TILE_ZOOM = "zoom";
+inline constexpr const char *STATS_TILE_X = "x";
+inline constexpr const char *STATS_TILE_Y = "y";
+inline constexpr const char *STATS_TILE_BBOX = "bbox";
 
 // Типы запросов/ответов
 inline constexpr const char *REQUEST_BUS = "Bus";
 inline constexpr const char *REQUEST_STOP = "Stop";
 inline constexpr const char *REQUEST_MAP = "Map";
+inline constexpr const char *REQUEST_TILE = "Tile";
 inline constexpr const char *REQUEST_ROUTE = "Route";
 
 // Названия полей. Общее
@@ -94,7 +120,9 @@ inline constexpr const char *ROUTE_RESPONSE_WAIT = "Wait";
 
 } // namespace
 
-template <typename Type> inline Type getValue(const Node &node) {
+// Шаблоны работают и с json::Node, и с json::arena::Node
+template <typename Type, typename NodeType>
+inline Type getValue(const NodeType &node) {
   if constexpr (std::is_same_v<Type, double>) {
     if (node.IsDouble()) {
       return node.AsDouble();
@@ -115,9 +143,11 @@ template <typename Type> inline Type getValue(const Node &node) {
       return static_cast<uint>(node.AsInt());
     }
   }
-  if constexpr (std::is_same_v<Type, std::string>) {
+  // string_view ссылается на строку узла и действителен, пока жив документ
+  if constexpr (std::is_same_v<Type, std::string> ||
+                std::is_same_v<Type, std::string_view>) {
     if (node.IsString()) {
-      return node.AsString();
+      return Type(node.AsString());
     }
   }
   if constexpr (std::is_same_v<Type, bool>) {
@@ -128,8 +158,8 @@ template <typename Type> inline Type getValue(const Node &node) {
   return {};
 }
 
-template <typename Type>
-inline Type getValue(const Dict &map, const string &json_var_name) {
+template <typename Type, typename DictType>
+inline Type getValue(const DictType &map, const string &json_var_name) {
   Type result{};
   if (const auto iter = map.find(json_var_name); iter != map.end()) {
     result = getValue<Type>(iter->second);
@@ -137,13 +167,13 @@ inline Type getValue(const Dict &map, const string &json_var_name) {
   return result;
 }
 
-template <typename Type>
-inline std::vector<Type> getVector(const Dict &map,
+template <typename Type, typename DictType>
+inline std::vector<Type> getVector(const DictType &map,
                                    const string &json_var_name) {
   std::vector<Type> result{};
   if (const auto iter = map.find(json_var_name);
       iter != map.end() && iter->second.IsArray()) {
-    Array son_vector = iter->second.AsArray();
+    const auto &son_vector = iter->second.AsArray();
     result.reserve(son_vector.size());
     transform(son_vector.begin(), son_vector.end(), back_inserter(result),
               [](const auto &node) { return getValue<Type>(node); });
@@ -151,10 +181,10 @@ inline std::vector<Type> getVector(const Dict &map,
   return result;
 }
 
-template <typename Type, size_t Count>
-inline std::array<Type, Count> getArray(const Node &node) {
+template <typename Type, size_t Count, typename NodeType>
+inline std::array<Type, Count> getArray(const NodeType &node) {
   std::array<Type, Count> result{};
-  if (Array array = node.AsArray(); !array.empty()) {
+  if (const auto &array = node.AsArray(); !array.empty()) {
     for (size_t i = 0; i < std::min(array.size(), Count); ++i) {
       result.at(i) = getValue<Type>(array.at(i));
     }
@@ -162,8 +192,8 @@ inline std::array<Type, Count> getArray(const Node &node) {
   return result;
 }
 
-template <typename Type, size_t Count>
-inline std::array<Type, Count> getArray(const Dict &map,
+template <typename Type, size_t Count, typename DictType>
+inline std::array<Type, Count> getArray(const DictType &map,
                                         const string &json_var_name) {
   std::array<Type, Count> result{};
   if (const auto iter = map.find(json_var_name);
@@ -173,15 +203,16 @@ inline std::array<Type, Count> getArray(const Dict &map,
   return result;
 }
 
-template <typename Type>
-inline std::map<std::string, Type> getMap(const Dict &map,
-                                          const string &json_var_name) {
-  std::map<std::string, Type> result{};
+// Ключи ссылаются на строки документа
+template <typename Type, typename DictType>
+inline std::map<std::string_view, Type> getMap(const DictType &map,
+                                               const string &json_var_name) {
+  std::map<std::string_view, Type> result{};
   if (const auto iter = map.find(json_var_name);
       iter != map.end() && iter->second.IsDict()) {
-    const Dict son_map{iter->second.AsDict()};
+    const auto &son_map = iter->second.AsDict();
     for (const auto &[name, node] : son_map) {
-      result.emplace(name, getValue<Type>(son_map, name));
+      result.emplace(name, getValue<Type>(node));
     }
   }
   return result;
@@ -278,7 +309,7 @@ uniqueQueryList ParserRenderSettings::parseSection(const Node &node) const {
 
 /*--------------------------- JsonOutputter ----------------------------------*/
 transport::JsonOutputter::JsonOutputter(ostream &output_stream)
-    : output_stream_(output_stream) {
+    : output_stream_(output_stream), writer_(output_stream) {
   //  output_stream_.unsetf(ios::fixed);
 }
 
@@ -291,114 +322,104 @@ std::unique_ptr<Outputter> JsonOutputter::Construct(ostream &stream) {
 }
 
 void JsonOutputter::Send() {
-  if (!root_array_.empty()) {
-    Print(json::Document(json::Builder{}.Value(root_array_).Build()),
-          output_stream_);
+  if (writer_.IsOpen()) {
+    writer_.EndArray();
+    output_stream_.flush();
+  }
+}
+
+// Ответы пишутся в поток сразу; массив ответов открывается с первым из них.
+// Ключи выводятся в алфавитном порядке, как в словаре json::Dict
+Writer &JsonOutputter::StartResponse() {
+  if (!writer_.IsOpen()) {
+    writer_.StartArray();
   }
-  root_array_.clear();
+  return writer_.StartDict();
 }
 
 void JsonOutputter::visit(queries::EmptyResponse *response) {
-  root_array_.emplace_back(Builder{}
-                               .StartDict()
-                               .Key(RESPONSE_ID)
-                               .Value(response->getId())
-                               .Key(ERROR_FIELD)
-                               .Value(std::string(ERROR_MESSAGE))
-                               .EndDict()
-                               .Build());
+  StartResponse()
+      .Key(ERROR_FIELD)
+      .Value(ERROR_MESSAGE)
+      .Key(RESPONSE_ID)
+      .Value(response->getId())
+      .EndDict();
 }
 
 void JsonOutputter::visit(queries::bus::StatResponse *response) {
-  root_array_.emplace_back(
-      Builder{}
-          .StartDict()
-          .Key(RESPONSE_ID)
-          .Value(response->getId())
-          .Key(BUS_CURVATURE)
-          .Value(static_cast<double>(response->getRouteLength() /
-                                     response->getGeoLength()))
-          .Key(BUS_ROUTE_LENGTH)
-          .Value(response->getRouteLength())
-          .Key(BUS_STOP_COUNT)
-          .Value(response->getStopsCount())
-          .Key(BUS_UNIQUE_STOP_COUNT)
-          .Value(response->getUniqueStopsCount())
-          .EndDict()
-          .Build());
+  // у маршрута без остановок или из одной остановки нет длины
+  const double curvature =
+      response->getGeoLength() > 0.
+          ? response->getRouteLength() / response->getGeoLength()
+          : 0.;
+  StartResponse()
+      .Key(BUS_CURVATURE)
+      .Value(curvature)
+      .Key(RESPONSE_ID)
+      .Value(response->getId())
+      .Key(BUS_ROUTE_LENGTH)
+      .Value(response->getRouteLength())
+      .Key(BUS_STOP_COUNT)
+      .Value(response->getStopsCount())
+      .Key(BUS_UNIQUE_STOP_COUNT)
+      .Value(response->getUniqueStopsCount())
+      .EndDict();
 }
 
 void JsonOutputter::visit(queries::stop::StatResponse *response) {
-  Array info_buses{};
-  transform(response->buses_cbegin(), response->buses_cend(),
-            back_inserter(info_buses),
-            [](const std::string &bus) { return Node(bus); });
-  root_array_.emplace_back(Builder{}
-                               .StartDict()
-                               .Key(RESPONSE_ID)
-                               .Value(response->getId())
-                               .Key(STOP_BUSES)
-                               .Value(info_buses)
-                               .EndDict()
-                               .Build());
+  StartResponse().Key(STOP_BUSES).StartArray();
+  for_each(response->buses_cbegin(), response->buses_cend(),
+           [this](std::string_view bus) { writer_.Value(bus); });
+  writer_.EndArray().Key(RESPONSE_ID).Value(response->getId()).EndDict();
 }
 
 void JsonOutputter::visit(queries::map::MapResponse *response) {
-  root_array_.emplace_back(Builder{}
-                               .StartDict()
-                               .Key(RESPONSE_ID)
-                               .Value(response->getId())
-                               .Key(RESPONSE_MAP)
-                               .Value(response->getMap())
-                               .EndDict()
-                               .Build());
+  StartResponse()
+      .Key(RESPONSE_MAP)
+      .Value(response->getMap())
+      .Key(RESPONSE_ID)
+      .Value(response->getId())
+      .EndDict();
 }
 
 void JsonOutputter::visit(queries::router::RouteResponse *response) {
-  struct items_to_node {
-    Node operator()(const RouteItemBus &bus_info) const {
-      return Builder{}
-          .StartDict()
-          .Key(TYPE_FIELD)
-          .Value(REQUEST_BUS)
+  struct item_writer {
+    Writer &writer;
+    void operator()(const RouteItemBus &bus_info) const {
+      writer.StartDict()
           .Key(ROUTE_RESPONSE_BUS_NAME)
-          .Value(string(bus_info.bus_name))
+          .Value(bus_info.bus_name)
           .Key(ROUTE_RESPONSE_SPAN_COUNT)
           .Value(bus_info.span_count)
           .Key(ROUTE_RESPONSE_TIME)
           .Value(bus_info.time)
-          .EndDict()
-          .Build();
-    };
-    Node operator()(const RouteItemStop &stop_info) const {
-      return Builder{}
-          .StartDict()
           .Key(TYPE_FIELD)
-          .Value(ROUTE_RESPONSE_WAIT)
+          .Value(REQUEST_BUS)
+          .EndDict();
+    };
+    void operator()(const RouteItemStop &stop_info) const {
+      writer.StartDict()
           .Key(ROUTE_RESPONSE_STOP_NAME)
-          .Value(string(stop_info.name))
+          .Value(stop_info.name)
           .Key(ROUTE_RESPONSE_TIME)
           .Value(stop_info.wait_time)
-          .EndDict()
-          .Build();
+          .Key(TYPE_FIELD)
+          .Value(ROUTE_RESPONSE_WAIT)
+          .EndDict();
     };
   };
 
-  Array items{};
-  items.reserve(response->items_size());
-  transform(
-      response->items_cbegin(), response->items_cend(), back_inserter(items),
-      [](const RouteItem &item) { return std::visit(items_to_node{}, item); });
-  root_array_.emplace_back(Builder{}
-                               .StartDict()
-                               .Key(RESPONSE_ID)
-                               .Value(response->getId())
-                               .Key(ROUTE_RESPONSE_TOTAL_TIME)
-                               .Value(response->getTotalTime())
-                               .Key(ROUTE_RESPONSE_ITEMS)
-                               .Value(items)
-                               .EndDict()
-                               .Build());
+  StartResponse().Key(ROUTE_RESPONSE_ITEMS).StartArray();
+  for_each(response->items_cbegin(), response->items_cend(),
+           [this](const RouteItem &item) {
+             std::visit(item_writer{writer_}, item);
+           });
+  writer_.EndArray()
+      .Key(RESPONSE_ID)
+      .Value(response->getId())
+      .Key(ROUTE_RESPONSE_TOTAL_TIME)
+      .Value(response->getTotalTime())
+      .EndDict();
 }
 
 /*--------------------------- JsonInputter ----------------------------------*/
@@ -439,26 +460,154 @@ void transport::JsonInputter::Parse() {
   if (input_stream_ && input_stream_.peek(), input_stream_.eof()) {
     return;
   }
-  Dict root;
+  RequestsHandler handler;
   try {
-    Document request_doc(Load(input_stream_));
-    const Node &root_node = request_doc.GetRoot();
-    if (root_node.IsDict()) {
-      root = root_node.AsDict();
-    }
+    json::Parse(input_stream_, handler);
   } catch (const std::exception &e) {
     std::cout << "A standard exception was caught, with message '" << e.what()
               << "'" << std::endl;
     return;
   }
   input_stream_.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-  for_each(root.begin(), root.end(), [this](const auto &section) {
-    // Выбрать парсер по названию элемента словаря
-    const auto &parser =
-        transport::io::json::detail::ParserBuilder::CreateParser(section.first);
-    auto requests = parser.parseSection(section.second);
-    move(requests.begin(), requests.end(), back_inserter(requests_));
-  });
+  requests_ = handler.Extract();
+}
+
+/*--------------------------- RequestsHandler -------------------------------*/
+void RequestsHandler::StartDict() {
+  if (depth_++ == 0 || ignore_) {
+    return;
+  }
+  Target().StartDict();
+}
+
+void RequestsHandler::Key(std::string_view key) {
+  if (ignore_) {
+    return;
+  }
+  if (depth_ > 1) {
+    Target().Key(key);
+    return;
+  }
+  auto [iter, inserted] = sections_.try_emplace(string(key));
+  if (!inserted) {
+    throw ParsingError("Duplicate key '"s + iter->first + "' have been found");
+  }
+  section_ = &iter->second;
+  // base_requests может идти после этого раздела
+  if (key == SERIALIZATION_SETTINGS) {
+    parser_ = nullptr;
+    return;
+  }
+  // Выбрать парсер по названию раздела
+  parser_ = &ParserBuilder::CreateParser(key);
+}
+
+void RequestsHandler::EndDict() {
+  if (--depth_ == 0 || ignore_) {
+    return;
+  }
+  Target().EndDict();
+  if (IsValueEnd()) {
+    Complete();
+  }
+}
+
+void RequestsHandler::StartArray() {
+  if (depth_++ == 0) {
+    ignore_ = true;
+  }
+  if (ignore_) {
+    return;
+  }
+  if (depth_ == 2 && parser_ != nullptr && parser_->isElementwise()) {
+    elementwise_ = true;
+    return;
+  }
+  Target().StartArray();
+}
+
+void RequestsHandler::EndArray() {
+  if (--depth_ == 0 || ignore_) {
+    return;
+  }
+  if (depth_ == 1 && elementwise_) {
+    elementwise_ = false;
+    return;
+  }
+  Target().EndArray();
+  if (IsValueEnd()) {
+    Complete();
+  }
+}
+
+void RequestsHandler::Value(std::nullptr_t value) { Scalar(value); }
+
+void RequestsHandler::Value(bool value) { Scalar(value); }
+
+void RequestsHandler::Value(int value) { Scalar(value); }
+
+void RequestsHandler::Value(double value) { Scalar(value); }
+
+void RequestsHandler::Value(std::string_view value) { Scalar(value); }
+
+template <typename Type> void RequestsHandler::Scalar(Type value) {
+  if (depth_ == 0) {
+    ignore_ = true;
+  }
+  if (ignore_) {
+    return;
+  }
+  Target().Value(value);
+  if (IsValueEnd()) {
+    Complete();
+  }
+}
+
+uniqueQueryList RequestsHandler::Extract() {
+  // направление снимка известно только после разбора всех разделов
+  if (serialization_settings_) {
+    using Direction = ParserSerializationSettings::Direction;
+    const ParserSerializationSettings parser(
+        sections_.count(BASE_REQUESTS) != 0 ? Direction::SAVE
+                                            : Direction::LOAD);
+    sections_[SERIALIZATION_SETTINGS] =
+        parser.parseSection(*serialization_settings_);
+    serialization_settings_.reset();
+  }
+  uniqueQueryList result;
+  for (auto &[name, queries] : sections_) {
+    result.splice(result.end(), queries);
+  }
+  sections_.clear();
+  return result;
+}
+
+bool RequestsHandler::IsValueEnd() const {
+  return depth_ == (elementwise_ ? 2 : 1);
+}
+
+void RequestsHandler::Complete() {
+  if (elementwise_) {
+    if (auto query = parser_->parseElement(element_builder_.GetRoot());
+        query) {
+      section_->push_back(move(query));
+    }
+    element_builder_.Clear();
+    return;
+  }
+  if (parser_ == nullptr) {
+    serialization_settings_ = builder_.Extract();
+    return;
+  }
+  auto queries = parser_->parseSection(builder_.Extract());
+  section_->splice(section_->end(), queries);
+}
+
+json::Handler &RequestsHandler::Target() {
+  if (elementwise_) {
+    return element_builder_;
+  }
+  return builder_;
 }
 
 /*--------------------------- ParserBuilder --------------------------------*/
@@ -477,43 +626,30 @@ const Parser &ParserBuilder::CreateParser(string_view parser_type) {
 }
 
 /*------------------------------ Parser -----------------------------------*/
-uniqueQueryList ParserBase::parseSection(const Node &map) const {
-  if (!map.IsArray()) {
-    return {};
+uniqueQuery ParserBase::parseElement(const arena::Node &node) const {
+  if (!node.IsDict()) {
+    return nullptr;
   }
-  Array array = map.AsArray();
-  uniqueQueryList result;
-
-  for (const auto &request_node : array) {
-    if (!request_node.IsDict()) {
-      continue;
-    }
-    const Dict request = request_node.AsDict();
-    auto request_type = getValue<string>(request, TYPE_FIELD);
-    if (request_type.empty()) {
-      continue;
-    }
-    if (REQUEST_BUS == request_type) {
-      if (auto query = parseBusNode(request); query) {
-        result.push_back(move(query));
-      }
-    }
-    if (REQUEST_STOP == request_type) {
-      if (auto query = parseStopNode(request); query != nullptr) {
-        result.push_back(move(query));
-      }
-    }
+  const auto &request = node.AsDict();
+  auto request_type = getValue<string>(request, TYPE_FIELD);
+  if (REQUEST_BUS == request_type) {
+    return parseBusNode(request);
   }
-  return result;
+  if (REQUEST_STOP == request_type) {
+    return parseStopNode(request);
+  }
+  return nullptr;
 }
 
-uniqueQuery ParserBase::parseBusNode(const Dict &map) {
-  const auto name = getValue<string>(map, NAME_FIELD);
+template <typename DictType>
+uniqueQuery ParserBase::parseBusNode(const DictType &map) {
+  // названия не копируются: фабрика запроса берёт их из пула строк
+  const auto name = getValue<string_view>(map, NAME_FIELD);
   if (name.empty()) {
     return nullptr;
   }
   const auto is_roundtrip = getValue<bool>(map, BASE_REQUESTS_IS_ROUNDTRIP);
-  const auto stops = getVector<string>(map, BASE_REQUESTS_STOPS_FIELD);
+  const auto stops = getVector<string_view>(map, BASE_REQUESTS_STOPS_FIELD);
   return queries::bus::AddBusQuery::Factory()
       .SetName(name)
       .SetRoundTripMark(is_roundtrip)
@@ -521,8 +657,9 @@ uniqueQuery ParserBase::parseBusNode(const Dict &map) {
       .Construct();
 }
 
-uniqueQuery ParserBase::parseStopNode(const Dict &map) {
-  const auto name = getValue<string>(map, NAME_FIELD);
+template <typename DictType>
+uniqueQuery ParserBase::parseStopNode(const DictType &map) {
+  const auto name = getValue<string_view>(map, NAME_FIELD);
   if (name.empty()) {
     return nullptr;
   }
@@ -536,47 +673,33 @@ uniqueQuery ParserBase::parseStopNode(const Dict &map) {
       .Construct();
 }
 
-uniqueQueryList ParserStat::parseSection(const Node &map) const {
-  if (!map.IsArray()) {
-    return {};
+uniqueQuery ParserStat::parseElement(const arena::Node &node) const {
+  if (!node.IsDict()) {
+    return nullptr;
   }
-  uniqueQueryList result{};
-  Array array = map.AsArray();
-  for (const auto &request_node : array) {
-    if (!request_node.IsDict()) {
-      continue;
-    }
-    const Dict &request = request_node.AsDict();
-    auto request_type{getValue<string>(request, TYPE_FIELD)};
-    if (request_type.empty()) {
-      continue;
-    }
-    if (REQUEST_BUS == request_type) {
-      if (auto query = parseBusNode(request); query) {
-        result.push_back(move(query));
-      }
-    }
-    if (REQUEST_STOP == request_type) {
-      if (auto query = parseStopNode(request); query) {
-        result.push_back(move(query));
-      }
-    }
-    if (REQUEST_MAP == request_type) {
-      if (auto query = parseMapNode(request); query) {
-        result.push_back(move(query));
-      }
-    }
-    if (REQUEST_ROUTE == request_type) {
-      if (auto query = parseRouteNode(request); query) {
-        result.push_back(move(query));
-      }
-    }
+  const auto &request = node.AsDict();
+  auto request_type{getValue<string>(request, TYPE_FIELD)};
+  if (REQUEST_BUS == request_type) {
+    return parseBusNode(request);
   }
-  return result;
+  if (REQUEST_STOP == request_type) {
+    return parseStopNode(request);
+  }
+  if (REQUEST_MAP == request_type) {
+    return parseMapNode(request);
+  }
+  if (REQUEST_TILE == request_type) {
+    return parseTileNode(request);
+  }
+  if (REQUEST_ROUTE == request_type) {
+    return parseRouteNode(request);
+  }
+  return nullptr;
 }
 
-uniqueQuery ParserStat::parseBusNode(const Dict &map) {
-  const auto name = getValue<string>(map, NAME_FIELD);
+template <typename DictType>
+uniqueQuery ParserStat::parseBusNode(const DictType &map) {
+  const auto name = getValue<string_view>(map, NAME_FIELD);
   if (name.empty()) {
     return nullptr;
   }
@@ -587,8 +710,9 @@ uniqueQuery ParserStat::parseBusNode(const Dict &map) {
       .Construct();
 }
 
-uniqueQuery ParserStat::parseStopNode(const Dict &map) {
-  const auto name = getValue<string>(map, NAME_FIELD);
+template <typename DictType>
+uniqueQuery ParserStat::parseStopNode(const DictType &map) {
+  const auto name = getValue<string_view>(map, NAME_FIELD);
   if (name.empty()) {
     return nullptr;
   }
@@ -599,15 +723,48 @@ uniqueQuery ParserStat::parseStopNode(const Dict &map) {
       .Construct();
 }
 
-const uniqueQuery ParserStat::parseMapNode(const Dict &map) {
+template <typename DictType>
+const uniqueQuery ParserStat::parseMapNode(const DictType &map) {
   // Пока самого запроса хватит для постоения карты всех маршрутов
   const auto requestId = getValue<int>(map, JSON_REQUEST_ID);
   return queries::map::MapRender::Factory().SetId(requestId).Construct();
 }
 
-const uniqueQuery ParserStat::parseRouteNode(const Dict &map) {
-  const auto stop_from = getValue<string>(map, STATS_ROUTE_STOP_FROM);
-  const auto stop_to = getValue<string>(map, STATS_ROUTE_STOP_TO);
+template <typename DictType>
+const uniqueQuery ParserStat::parseTileNode(const DictType &map) {
+  const auto requestId = getValue<int>(map, JSON_REQUEST_ID);
+  auto factory = queries::map::TileRender::Factory();
+  factory.SetId(requestId);
+  // неверная область не задаётся: на запрос придёт ответ "not found"
+  // bbox: [min_x, min_y, max_x, max_y] в координатах холста карты
+  if (const auto iter = map.find(STATS_TILE_BBOX);
+      iter != map.end() && iter->second.IsArray()) {
+    if (4 != iter->second.AsArray().size()) {
+      return factory.Construct();
+    }
+    const auto bbox = getArray<double, 4>(iter->second);
+    if (bbox.at(2) < bbox.at(0) || bbox.at(3) < bbox.at(1)) {
+      return factory.Construct();
+    }
+    return factory.SetBox({bbox.at(0), bbox.at(1), bbox.at(2), bbox.at(3)})
+        .Construct();
+  }
+  const auto zoom = getValue<int>(map, STATS_TILE_ZOOM);
+  const auto x = getValue<int>(map, STATS_TILE_X);
+  const auto y = getValue<int>(map, STATS_TILE_Y);
+  if (zoom < 0 || x < 0 || y < 0) {
+    return factory.Construct();
+  }
+  return factory
+      .SetAddress({static_cast<uint32_t>(zoom), static_cast<uint32_t>(x),
+                   static_cast<uint32_t>(y)})
+      .Construct();
+}
+
+template <typename DictType>
+const uniqueQuery ParserStat::parseRouteNode(const DictType &map) {
+  const auto stop_from = getValue<string_view>(map, STATS_ROUTE_STOP_FROM);
+  const auto stop_to = getValue<string_view>(map, STATS_ROUTE_STOP_TO);
   const auto requestId = getValue<int>(map, JSON_REQUEST_ID);
   return queries::router::RouteQuery::Factory()
       .SetFromStop(stop_from)
@@ -628,9 +785,64 @@ uniqueQueryList ParserRoutingSettings::parseSection(const Node &node) const {
   const auto bus_velocity =
       getValue<double>(settings_dict, ROUTING_SETTINGS_BUS_VELOCITY);
 
+  static const std::unordered_map<std::string_view, router::RouterMode>
+      router_modes = {{ROUTER_MODE_PRECOMPUTED, router::RouterMode::PRECOMPUTED},
+                      {ROUTER_MODE_PRECOMPUTED_COMPACT,
+                       router::RouterMode::PRECOMPUTED_COMPACT},
+                      {ROUTER_MODE_ON_DEMAND, router::RouterMode::ON_DEMAND},
+                      {ROUTER_MODE_CONTRACTION_HIERARCHY,
+                       router::RouterMode::CONTRACTION_HIERARCHY}};
+  // поле необязательно, но опечатка в нём не должна молча включать
+  // долгий предрасчёт
+  auto router_mode = router::RouterMode::PRECOMPUTED;
+  if (settings_dict.count(ROUTING_SETTINGS_ROUTER_MODE) != 0) {
+    const auto iter = router_modes.find(
+        getValue<string>(settings_dict, ROUTING_SETTINGS_ROUTER_MODE));
+    if (iter == router_modes.end()) {
+      throw std::logic_error("Unknown router mode");
+    }
+    router_mode = iter->second;
+  }
+
+  static const std::unordered_map<std::string_view, router::GraphModel>
+      graph_models = {
+          {GRAPH_MODEL_STOP_TO_STOP, router::GraphModel::STOP_TO_STOP},
+          {GRAPH_MODEL_RIDE_VERTICES, router::GraphModel::RIDE_VERTICES}};
+  auto graph_model = router::GraphModel::STOP_TO_STOP;
+  if (settings_dict.count(ROUTING_SETTINGS_GRAPH_MODEL) != 0) {
+    const auto iter = graph_models.find(
+        getValue<string>(settings_dict, ROUTING_SETTINGS_GRAPH_MODEL));
+    if (iter == graph_models.end()) {
+      throw std::logic_error("Unknown graph model");
+    }
+    graph_model = iter->second;
+  }
+
   auto query = queries::router::RoutingSettings::Factory()
                    .SetBusWaitTime(bus_wait)
                    .SetBusVelocity(bus_velocity)
+                   .SetRouterMode(router_mode)
+                   .SetGraphModel(graph_model)
+                   .SetRouterFile(getValue<string>(
+                       settings_dict, ROUTING_SETTINGS_ROUTER_FILE))
+                   .Construct();
+  uniqueQueryList result{};
+  result.push_back(move(query));
+  return result;
+}
+
+ParserSerializationSettings::ParserSerializationSettings(Direction direction)
+    : direction_(direction) {}
+
+uniqueQueryList
+ParserSerializationSettings::parseSection(const Node &node) const {
+  if (!node.IsDict()) {
+    return {};
+  }
+  auto query = queries::serialization::SerializationSettings::Factory()
+                   .SetFile(getValue<string>(node.AsDict(),
+                                             SERIALIZATION_SETTINGS_FILE))
+                   .SetDirection(direction_)
                    .Construct();
   uniqueQueryList result{};
   result.push_back(move(query));
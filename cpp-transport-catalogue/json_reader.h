@@ -2,7 +2,10 @@
 
 #include "request_handler.h"
 #include "json.h"
+#include "json_arena.h"
+#include <map>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 
 // using namespace json;
@@ -25,7 +28,10 @@ public:
 
 private:
   std::ostream &output_stream_;
-  json::Array root_array_{};
+  // ответы пишутся в поток по мере поступления, без дерева json::Node
+  ::json::Writer writer_;
+
+  ::json::Writer &StartResponse();
 };
 
 // Чтение данных из потока в формате JSON,и их обработка
@@ -58,8 +64,22 @@ public:
   Parser &operator=(const Parser &other) = delete;
   Parser &operator=(Parser &&other) = delete;
 
+  // Разбор раздела целиком
   [[nodiscard]] virtual uniqueQueryList
-  parseSection(const ::json::Node &map) const = 0;
+  parseSection(const ::json::Node & /*unused*/) const {
+    return {};
+  }
+
+  // Раздел-массив, элементы которого разбираются по одному. При потоковом
+  // разборе такой раздел целиком в памяти не строится. Раздел, оказавшийся
+  // не массивом, разбирается parseSection
+  [[nodiscard]] virtual bool isElementwise() const { return false; }
+
+  // Разбор одного элемента раздела-массива
+  [[nodiscard]] virtual uniqueQuery
+  parseElement(const ::json::arena::Node & /*unused*/) const {
+    return nullptr;
+  }
 
   virtual ~Parser() = default;
 };
@@ -67,25 +87,35 @@ public:
 class ParserBase final : public Parser {
 public:
   friend class ParserStat;
-  [[nodiscard]] uniqueQueryList
-  parseSection(const ::json::Node &map) const override;
+  [[nodiscard]] bool isElementwise() const override { return true; }
+  [[nodiscard]] uniqueQuery
+  parseElement(const ::json::arena::Node &node) const override;
 
 private:
-  static uniqueQuery parseBusNode(const ::json::Dict &map);
-  static uniqueQuery parseStopNode(const ::json::Dict &map);
+  template <typename DictType>
+  static uniqueQuery parseBusNode(const DictType &map);
+  template <typename DictType>
+  static uniqueQuery parseStopNode(const DictType &map);
 };
 
 class ParserStat final : public Parser {
 public:
   //  [[nodiscard]] RequestType GetType() const override;
-  [[nodiscard]] uniqueQueryList
-  parseSection(const ::json::Node &map) const override;
+  [[nodiscard]] bool isElementwise() const override { return true; }
+  [[nodiscard]] uniqueQuery
+  parseElement(const ::json::arena::Node &node) const override;
 
 private:
-  static uniqueQuery parseBusNode(const ::json::Dict &map);
-  static uniqueQuery parseStopNode(const ::json::Dict &map);
-  static const uniqueQuery parseMapNode(const ::json::Dict &map);
-  static const uniqueQuery parseRouteNode(const ::json::Dict &map);
+  template <typename DictType>
+  static uniqueQuery parseBusNode(const DictType &map);
+  template <typename DictType>
+  static uniqueQuery parseStopNode(const DictType &map);
+  template <typename DictType>
+  static const uniqueQuery parseMapNode(const DictType &map);
+  template <typename DictType>
+  static const uniqueQuery parseTileNode(const DictType &map);
+  template <typename DictType>
+  static const uniqueQuery parseRouteNode(const DictType &map);
 };
 
 class ParserRenderSettings final : public Parser {
@@ -101,6 +131,73 @@ public:
   parseSection(const ::json::Node &node) const override;
 };
 
+// Направление снимка зависит от наличия раздела base_requests, поэтому
+// разборщик создаётся после разбора всех разделов входа
+class ParserSerializationSettings final : public Parser {
+public:
+  using Direction = queries::serialization::SerializationSettings::Direction;
+
+  explicit ParserSerializationSettings(Direction direction);
+  [[nodiscard]] uniqueQueryList
+  parseSection(const ::json::Node &node) const override;
+
+private:
+  Direction direction_;
+};
+
+// Потоковый разбор запросов по событиям json::Parse. Разделы-массивы
+// (base_requests, stat_requests) разбираются по одному запросу по мере
+// закрытия его объекта, остальные разделы - целиком после закрытия раздела.
+// Дерево всего документа не строится
+class RequestsHandler final : public ::json::Handler {
+public:
+  RequestsHandler() = default;
+
+  void StartDict() override;
+  void Key(std::string_view key) override;
+  void EndDict() override;
+  void StartArray() override;
+  void EndArray() override;
+  void Value(std::nullptr_t value) override;
+  void Value(bool value) override;
+  void Value(int value) override;
+  void Value(double value) override;
+  void Value(std::string_view value) override;
+
+  // Запросы всех разделов в порядке названий разделов. Снимок из
+  // serialization_settings загружается, если во входе нет base_requests,
+  // иначе записывается
+  uniqueQueryList Extract();
+
+private:
+  // глубина вложенности: 1 - корневой словарь, 2 - значение раздела
+  size_t depth_ = 0;
+  // корень документа не словарь - запросов нет
+  bool ignore_ = false;
+  // разборщик текущего раздела; nullptr для serialization_settings,
+  // который разбирается в Extract
+  const Parser *parser_ = nullptr;
+  // текущий раздел разбирается по элементам
+  bool elementwise_ = false;
+  uniqueQueryList *section_ = nullptr;
+  // строит текущий элемент в арене, переиспользуемой между элементами
+  ::json::arena::Builder element_builder_{};
+  // строит раздел целиком
+  ::json::NodeBuilder builder_{};
+  std::map<std::string, uniqueQueryList> sections_{};
+  // раздел serialization_settings до разбора
+  std::optional<::json::Node> serialization_settings_{};
+
+  // Закончено значение на текущей глубине: раздел или элемент раздела
+  [[nodiscard]] bool IsValueEnd() const;
+  // Разбирает построенный раздел или элемент раздела
+  void Complete();
+  // Получатель событий текущего значения
+  ::json::Handler &Target();
+  // Передаёт скалярное значение получателю
+  template <typename Type> void Scalar(Type value);
+};
+
 class ParserBuilder {
 public:
   // Создать класс-разборщик
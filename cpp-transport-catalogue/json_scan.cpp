@@ -0,0 +1,180 @@
+#include "json_scan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#include <immintrin.h>
+#define JSON_SCAN_X86
+#endif
+
+namespace {
+
+inline bool IsStringSpecial(char chr) {
+  return chr == '"' || chr == '\\' || chr == '\n' || chr == '\r';
+}
+
+inline bool IsSpace(char chr) {
+  return chr == ' ' || chr == '\n' || chr == '\r' || chr == '\t' ||
+         chr == '\v' || chr == '\f';
+}
+
+const char *FindStringSpecialScalar(const char *begin, const char *end) {
+  while (begin != end && !IsStringSpecial(*begin)) {
+    ++begin;
+  }
+  return begin;
+}
+
+const char *SkipSpacesScalar(const char *begin, const char *end) {
+  while (begin != end && IsSpace(*begin)) {
+    ++begin;
+  }
+  return begin;
+}
+
+#ifdef JSON_SCAN_X86
+
+// Маска байтов блока, равных одному из символов строки, и маска пробельных
+// байтов. '\t', '\n', '\v', '\f', '\r' идут подряд: 0x09..0x0D
+
+inline unsigned StringSpecialMask(__m128i block) {
+  const __m128i special =
+      _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('"')),
+                                _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'))),
+                   _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')),
+                                _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'))));
+  return static_cast<unsigned>(_mm_movemask_epi8(special));
+}
+
+inline unsigned SpaceMask(__m128i block) {
+  // байт в 0x09..0x0D: (byte - 0x09) без знака не больше 4
+  const __m128i control = _mm_cmpeq_epi8(
+      _mm_min_epu8(_mm_sub_epi8(block, _mm_set1_epi8('\t')),
+                   _mm_set1_epi8(4)),
+      _mm_sub_epi8(block, _mm_set1_epi8('\t')));
+  const __m128i space =
+      _mm_or_si128(control, _mm_cmpeq_epi8(block, _mm_set1_epi8(' ')));
+  return static_cast<unsigned>(_mm_movemask_epi8(space));
+}
+
+const char *FindStringSpecialSse2(const char *begin, const char *end) {
+  for (; end - begin >= 16; begin += 16) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    if (const unsigned mask = StringSpecialMask(block); mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return FindStringSpecialScalar(begin, end);
+}
+
+const char *SkipSpacesSse2(const char *begin, const char *end) {
+  for (; end - begin >= 16; begin += 16) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    if (const unsigned mask = ~SpaceMask(block) & 0xFFFFU; mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return SkipSpacesScalar(begin, end);
+}
+
+__attribute__((target("avx2"))) const char *
+FindStringSpecialAvx2(const char *begin, const char *end) {
+  for (; end - begin >= 32; begin += 32) {
+    const __m256i block =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+    const __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('"')),
+                        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\\'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')),
+                        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r'))));
+    if (const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+        mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return FindStringSpecialSse2(begin, end);
+}
+
+__attribute__((target("avx2"))) const char *
+SkipSpacesAvx2(const char *begin, const char *end) {
+  for (; end - begin >= 32; begin += 32) {
+    const __m256i block =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+    const __m256i shifted = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+    const __m256i control = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    const __m256i space = _mm256_or_si256(
+        control, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')));
+    if (const auto mask = ~static_cast<unsigned>(_mm256_movemask_epi8(space));
+        mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return SkipSpacesSse2(begin, end);
+}
+
+#endif
+
+using json::detail::ScanImplementation;
+
+// Реализация поиска, выбранная один раз при запуске: последняя доступная
+ScanImplementation SelectImplementation() {
+  return json::detail::GetScanImplementations().back();
+}
+
+const ScanImplementation IMPLEMENTATION = SelectImplementation();
+
+} // namespace
+
+std::vector<ScanImplementation> json::detail::GetScanImplementations() {
+  std::vector<ScanImplementation> implementations{
+      {"scalar", FindStringSpecialScalar, SkipSpacesScalar}};
+#ifdef JSON_SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) {
+    implementations.push_back(
+        {"sse2", FindStringSpecialSse2, SkipSpacesSse2});
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    implementations.push_back(
+        {"avx2", FindStringSpecialAvx2, SkipSpacesAvx2});
+  }
+#endif
+  return implementations;
+}
+
+// Короткие участки (имена, отступы) проверяются одним блоком SSE2 на месте,
+// выбранная при запуске реализация вызывается только для длинных
+
+const char *json::detail::FindStringSpecial(const char *begin,
+                                            const char *end) {
+#ifdef JSON_SCAN_X86
+  if (end - begin >= 16) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    if (const unsigned mask = StringSpecialMask(block); mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+    begin += 16;
+  }
+#endif
+  return IMPLEMENTATION.find_string_special(begin, end);
+}
+
+const char *json::detail::SkipSpaces(const char *begin, const char *end) {
+  // после лексемы чаще всего сразу идёт следующая, без пробелов
+  if (begin != end && !IsSpace(*begin)) {
+    return begin;
+  }
+#ifdef JSON_SCAN_X86
+  if (end - begin >= 16) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    if (const unsigned mask = ~SpaceMask(block) & 0xFFFFU; mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+    begin += 16;
+  }
+#endif
+  return IMPLEMENTATION.skip_spaces(begin, end);
+}
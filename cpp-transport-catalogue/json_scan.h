@@ -0,0 +1,29 @@
+#pragma once
+
+// Поиск структурных символов JSON в буфере блоками по 16/32 байта (SSE2/AVX2).
+// Набор инструкций выбирается при запуске по возможностям процессора, на
+// других архитектурах используется скалярный поиск
+
+#include <vector>
+
+namespace json::detail {
+
+// Первый символ в [begin, end), прерывающий простой участок строки: кавычка,
+// обратная косая черта или перевод строки. end, если такого нет
+const char *FindStringSpecial(const char *begin, const char *end);
+
+// Первый непробельный символ в [begin, end). end, если такого нет
+const char *SkipSpaces(const char *begin, const char *end);
+
+// Реализация поиска для одного набора инструкций
+struct ScanImplementation {
+  const char *name;
+  const char *(*find_string_special)(const char *, const char *);
+  const char *(*skip_spaces)(const char *, const char *);
+};
+
+// Реализации, доступные на этом процессоре, для сравнения в тестах. Первая -
+// скалярная
+std::vector<ScanImplementation> GetScanImplementations();
+
+} // namespace json::detail
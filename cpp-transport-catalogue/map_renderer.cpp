@@ -1,4 +1,5 @@
 #include "map_renderer.h"
+#include <array>
 #include <unordered_map>
 
 inline constexpr const char *MAP_ROUTE_NAME_FONT_FAMILY = "Verdana";
@@ -20,10 +21,66 @@ svg::Point transport::renderer::SphereProjector::operator()(
 }
 
 /* ----------------------- Созидатель карты -------------------------------- */
+namespace {
+using RouteView = TransportCatalogue::RouteView;
+
+// Маршруты в порядке вывода - по названию. Копируются только представления
+std::vector<RouteView>
+SortRoutes(const TransportCatalogue::RoutesView &routes) {
+  std::vector<RouteView> result(routes.begin(), routes.end());
+  stable_sort(result.begin(), result.end(),
+              [](const RouteView &lhs, const RouteView &rhs) {
+                return lhs.name() < rhs.name();
+              });
+  return result;
+}
+
+// Проектор по остановкам маршрутов; routes не пуст
+SphereProjector MakeProjector(const std::vector<RouteView> &routes,
+                              const RenderSettings &settings) {
+  // Проектору нужны только крайние широта и долгота, поэтому вместо всех
+  // координат ему передаются два угла охватывающего прямоугольника
+  std::array<detail::Coordinates, 2> geo_bounds{
+      routes.front().stopAt(0).coordinates,
+      routes.front().stopAt(0).coordinates};
+  for (const RouteView &route : routes) {
+    for (size_t index = 0; index < route.size(); ++index) {
+      const detail::Coordinates coordinates = route.stopAt(index).coordinates;
+      geo_bounds[0].lat = std::min(geo_bounds[0].lat, coordinates.lat);
+      geo_bounds[0].lng = std::min(geo_bounds[0].lng, coordinates.lng);
+      geo_bounds[1].lat = std::max(geo_bounds[1].lat, coordinates.lat);
+      geo_bounds[1].lng = std::max(geo_bounds[1].lng, coordinates.lng);
+    }
+  }
+  return {geo_bounds.begin(), geo_bounds.end(), settings.width(),
+          settings.height(), settings.padding()};
+}
+
+// Оценка области надписи сверху: ширина символа не больше размера шрифта,
+// подложка расширяет надпись на свою толщину
+TileBox LabelBox(svg::Point position, svg::Point offset, uint32_t font_size,
+                 double underlayer_width, std::string_view text) {
+  const double size = font_size;
+  const double left = position.x + offset.x;
+  const double baseline = position.y + offset.y;
+  return TileBox{left, baseline - size,
+                 left + size * static_cast<double>(text.size()),
+                 baseline + size / 2}
+      .Expanded(underlayer_width);
+}
+} // namespace
+
 void transport::MapRenderer_impl::SetSettings(
     const renderer::RenderSettings &settings) {
   if (settings.isValid()) {
     settings_ = settings;
+    // карта и индекс плиток с прежними настройками больше не годятся
+    {
+      const std::lock_guard lock(cache_mutex_);
+      cache_ = {};
+    }
+    const std::lock_guard lock(tile_mutex_);
+    tile_cache_ = {};
   }
   //  cout << "Установленны на стройки MapRenderer" << endl;
 }
@@ -79,100 +136,77 @@ svg::Text MapRenderer_impl::createDefaultStopName_underlayer_() const {
       .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 }
 
-svg::Document
-MapRenderer_impl::renderRoutesMap(const std::vector<BusInfo> &bus_info) const {
-
-  if (bus_info.empty()) {
-    return {};
-  }
-  settings_.resetColorPalette();
+svg::Document MapRenderer_impl::renderRoutesMap(
+    const TransportCatalogue::RoutesView &routes) const {
+  svg::Document doc;
+  renderLayers_(routes, doc);
+  return doc;
+}
 
-  std::vector<BusInfo> bus_routes(bus_info);
+void MapRenderer_impl::renderRoutesMap(
+    const TransportCatalogue::RoutesView &routes, std::ostream &out) const {
+  svg::StreamDocument doc(out);
+  renderLayers_(routes, doc);
+  doc.Close();
+}
 
-  // Построчное создание картинки svg
-  stable_sort(bus_routes.begin(), bus_routes.end(),
-              [](const BusInfo &lhs, const BusInfo &rhs) {
-                return lhs.name < rhs.name;
-              });
-  // Сливаю координаты в один вектор
-  vector<detail::Coordinates> geo_coords;
-  for (const auto &route : bus_routes) {
-    transform(route.stops.begin(), route.stops.end(), back_inserter(geo_coords),
-              [](const StopInfo &stop_info) { return stop_info.coordinates; });
+template <typename Container>
+void MapRenderer_impl::renderLayers_(
+    const TransportCatalogue::RoutesView &routes, Container &doc) const {
+  // маршруты читаются из справочника на месте, копируются только их
+  // представления для сортировки
+  const std::vector<RouteView> bus_routes = SortRoutes(routes);
+  if (bus_routes.empty()) {
+    return;
   }
   // Создаём проектор сферических координат на карту
-  const renderer::SphereProjector proj{geo_coords.begin(), geo_coords.end(),
-                                       settings_.width(), settings_.height(),
-                                       settings_.padding()};
+  const renderer::SphereProjector proj = MakeProjector(bus_routes, settings_);
 
-  // Вывожу заготовку для svg|xml
-  svg::Document doc;
-  std::vector<std::pair<std::string_view, svg::Point>> stops;
+  // остановки без повторов: первое вхождение каждой
+  std::unordered_map<std::string_view, svg::Point> unique_stops{};
   std::unordered_map<std::string_view, svg::Color> bus_colors{};
+  // номер цвета палитры для очередного маршрута
+  size_t color_index = 0;
   // СЛОЙ 1. Ломаные линии маршрутов
-  for (BusInfo &route : bus_routes) {
-    if (!route.stops.empty()) {
-      svg::Color bus_color = settings_.nextColor();
-      svg::Polyline route_polyline(
-          createDefaultRoute_().SetStrokeColor(bus_color));
-
-      //туда
-      for_each(route.stops.begin(), route.stops.end(),
-               [&](const auto &stop_info) {
-                 svg::Point stop_point = proj(stop_info.coordinates);
-                 route_polyline.AddPoint(stop_point);
-                 stops.emplace_back(stop_info.name, stop_point);
-               });
-      if (!route.is_roundtrip) {
-        // и обратно
-        for_each(next(route.stops.rbegin()), route.stops.rend(),
-                 [&](const auto &stop_info) {
-                   svg::Point stop_point = proj(stop_info.coordinates);
-                   route_polyline.AddPoint(stop_point);
-                   stops.emplace_back(stop_info.name, stop_point);
-                 });
+  for (const RouteView &route : bus_routes) {
+    svg::Color bus_color = settings_.paletteColor(color_index++);
+    svg::Polyline route_polyline(
+        createDefaultRoute_().SetStrokeColor(bus_color));
+    const auto add_stop = [&](size_t index) {
+      const StopInfo stop_info = route.stopAt(index);
+      svg::Point stop_point = proj(stop_info.coordinates);
+      route_polyline.AddPoint(stop_point);
+      unique_stops.emplace(stop_info.name, stop_point);
+    };
+    //туда
+    for (size_t index = 0; index < route.size(); ++index) {
+      add_stop(index);
+    }
+    if (!route.isRoundtrip()) {
+      // и обратно
+      for (size_t index = route.size() - 1; index > 0; --index) {
+        add_stop(index - 1);
       }
-      doc.Add(route_polyline);
-      bus_colors.emplace(route.name, bus_color);
     }
+    doc.Add(route_polyline);
+    bus_colors.emplace(route.name(), bus_color);
   }
   // СЛОЙ 2. Названия маршрутов
-  for (const BusInfo &route : bus_routes) {
-    svg::Color bus_color = bus_colors.at(route.name);
-    svg::Point first_stop_point = proj(route.stops.front().coordinates);
-    doc.Add(svg::Text(createDefaultRouteName_underlayer_()
-                          .SetData(string(route.name))
-                          .SetPosition(first_stop_point)));
-
-    doc.Add(svg::Text(createDefaultRouteName_()
-                          .SetPosition(first_stop_point)
-                          .SetFillColor(bus_color)
-                          .SetData(string(route.name))
-                          .SetFillColor(bus_color)));
-    svg::Point second_stop_point = proj(route.stops.back().coordinates);
-
-    if (!route.is_roundtrip &&
-        route.stops.front().name != route.stops.back().name) {
-
-      doc.Add(svg::Text(createDefaultRouteName_underlayer_()
-                            .SetData(string(route.name))
-                            .SetPosition(second_stop_point)));
-
-      doc.Add(svg::Text(createDefaultRouteName_()
-                            .SetData(string(route.name))
-                            .SetPosition(second_stop_point)
-                            .SetFillColor(bus_color)));
+  for (const RouteView &route : bus_routes) {
+    svg::Color bus_color = bus_colors.at(route.name());
+    const StopInfo first_stop = route.stopAt(0);
+    const StopInfo last_stop = route.stopAt(route.size() - 1);
+    addRouteName_(doc, route.name(), proj(first_stop.coordinates), bus_color);
+    if (!route.isRoundtrip() && first_stop.name != last_stop.name) {
+      addRouteName_(doc, route.name(), proj(last_stop.coordinates), bus_color);
     }
   }
 
-  stable_sort(stops.begin(), stops.end(), [](const auto &lhv, const auto &rhv) {
+  std::vector<std::pair<std::string_view, svg::Point>> stops(
+      unique_stops.begin(), unique_stops.end());
+  sort(stops.begin(), stops.end(), [](const auto &lhv, const auto &rhv) {
     return lhv.first < rhv.first;
   });
-  auto last =
-      unique(stops.begin(), stops.end(), [](const auto &lhv, const auto &rhv) {
-        return lhv.first == rhv.first;
-      });
-  stops.erase(last, stops.end());
 
   // СЛОЙ 3. Круги, обозначающие остановки
   for (const auto &[name, stop_point] : stops) {
@@ -185,16 +219,203 @@ MapRenderer_impl::renderRoutesMap(const std::vector<BusInfo> &bus_info) const {
 
   // СЛОЙ 4. Названия остановок
   for (const auto &[name, stop_point] : stops) {
-    doc.Add(svg::Text(createDefaultStopName_underlayer_()
-                          .SetPosition(stop_point)
-                          .SetData(string(name))));
-    doc.Add(svg::Text(createDefaultStopName_()
-                          .SetPosition(stop_point)
-                          .SetData(string(name))));
+    addStopName_(doc, name, stop_point);
   }
+}
 
-  // Завершаю "рисование"
-  return doc;
+template <typename Container>
+void MapRenderer_impl::addRouteName_(Container &doc, std::string_view name,
+                                     svg::Point position,
+                                     const svg::Color &color) const {
+  doc.Add(svg::Text(createDefaultRouteName_underlayer_()
+                        .SetData(string(name))
+                        .SetPosition(position)));
+  doc.Add(svg::Text(createDefaultRouteName_()
+                        .SetPosition(position)
+                        .SetFillColor(color)
+                        .SetData(string(name))));
+}
+
+template <typename Container>
+void MapRenderer_impl::addStopName_(Container &doc, std::string_view name,
+                                    svg::Point position) const {
+  doc.Add(svg::Text(createDefaultStopName_underlayer_()
+                        .SetPosition(position)
+                        .SetData(string(name))));
+  doc.Add(svg::Text(
+      createDefaultStopName_().SetPosition(position).SetData(string(name))));
+}
+
+std::shared_ptr<const std::string>
+MapRenderer_impl::renderMap(const TransportCatalogue &catalogue) const {
+  // одновременные запросы ждут первый, который построит карту
+  const std::lock_guard lock(cache_mutex_);
+  if (cache_.svg != nullptr &&
+      cache_.generation == catalogue.getGeneration()) {
+    return cache_.svg;
+  }
+  const auto routes = catalogue.getRoutesInfo();
+  if (!routes.has_value()) {
+    return nullptr;
+  }
+  svg::StringStream str_stream;
+  renderRoutesMap(routes.value(), str_stream);
+  cache_ = {catalogue.getGeneration(),
+            std::make_shared<const std::string>(str_stream.Release())};
+  return cache_.svg;
+}
+
+std::shared_ptr<const TileIndex>
+MapRenderer_impl::tileIndex_(const TransportCatalogue &catalogue) const {
+  const std::lock_guard lock(tile_mutex_);
+  if (tile_cache_.index != nullptr &&
+      tile_cache_.generation == catalogue.getGeneration()) {
+    return tile_cache_.index;
+  }
+  const auto routes = catalogue.getRoutesInfo();
+  if (!routes.has_value()) {
+    return nullptr;
+  }
+  // геометрия та же, что у полной карты: маршруты по названию, остановки без
+  // повторов по названию
+  auto index =
+      std::make_shared<TileIndex>(settings_.width(), settings_.height());
+  const std::vector<RouteView> bus_routes = SortRoutes(routes.value());
+  if (!bus_routes.empty()) {
+    const renderer::SphereProjector proj =
+        MakeProjector(bus_routes, settings_);
+    std::unordered_map<std::string_view, svg::Point> unique_stops{};
+    const auto add_route_label = [&](std::string_view name, svg::Point point) {
+      index->AddRouteLabel(point, LabelBox(point, settings_.busLabelOffset(),
+                                           settings_.busLabelFontSize(),
+                                           settings_.underlayerWidth(), name));
+    };
+    for (const RouteView &route : bus_routes) {
+      index->AddRoute(route.name());
+      const auto add_stop = [&](size_t stop_index) {
+        const StopInfo stop_info = route.stopAt(stop_index);
+        const svg::Point stop_point = proj(stop_info.coordinates);
+        index->AddPoint(stop_point);
+        unique_stops.emplace(stop_info.name, stop_point);
+      };
+      for (size_t stop_index = 0; stop_index < route.size(); ++stop_index) {
+        add_stop(stop_index);
+      }
+      if (!route.isRoundtrip()) {
+        for (size_t stop_index = route.size() - 1; stop_index > 0;
+             --stop_index) {
+          add_stop(stop_index - 1);
+        }
+      }
+      const StopInfo first_stop = route.stopAt(0);
+      const StopInfo last_stop = route.stopAt(route.size() - 1);
+      add_route_label(route.name(), proj(first_stop.coordinates));
+      if (!route.isRoundtrip() && first_stop.name != last_stop.name) {
+        add_route_label(route.name(), proj(last_stop.coordinates));
+      }
+    }
+    std::vector<std::pair<std::string_view, svg::Point>> stops(
+        unique_stops.begin(), unique_stops.end());
+    sort(stops.begin(), stops.end(), [](const auto &lhv, const auto &rhv) {
+      return lhv.first < rhv.first;
+    });
+    for (const auto &[name, stop_point] : stops) {
+      // область круга и надписи
+      const TileBox circle{stop_point.x, stop_point.y, stop_point.x,
+                           stop_point.y};
+      const TileBox label =
+          LabelBox(stop_point, settings_.stopLabelOffset(),
+                   settings_.stopLabelFontSize(), settings_.underlayerWidth(),
+                   name);
+      const TileBox box = circle.Expanded(settings_.stopRadius());
+      index->AddStop(name, stop_point,
+                     {std::min(box.min_x, label.min_x),
+                      std::min(box.min_y, label.min_y),
+                      std::max(box.max_x, label.max_x),
+                      std::max(box.max_y, label.max_y)});
+    }
+  }
+  index->Build(settings_.lineWidth());
+  tile_cache_ = {catalogue.getGeneration(), index};
+  return index;
+}
+
+std::shared_ptr<const std::string>
+MapRenderer_impl::renderTile(const TransportCatalogue &catalogue,
+                             const TileBox &box) const {
+  const auto index = tileIndex_(catalogue);
+  if (index == nullptr) {
+    return nullptr;
+  }
+  const TileIndex::Content content = index->Find(box);
+  svg::StringStream str_stream;
+  svg::StreamDocument doc(str_stream,
+                          svg::ViewBox{{box.min_x, box.min_y},
+                                       box.max_x - box.min_x,
+                                       box.max_y - box.min_y});
+
+  // СЛОЙ 1. Видимые части ломаных. Они обрезаются с запасом в толщину линии,
+  // чтобы скруглённые концы на месте обреза оказались за краем плитки
+  const TileBox clip_box = box.Expanded(settings_.lineWidth());
+  std::optional<svg::Polyline> route_polyline;
+  // вершина, на которой закончилась текущая ломаная без обрезки
+  std::optional<uint32_t> polyline_end;
+  for (const uint32_t segment : content.segments) {
+    const auto clipped = ClipSegment(clip_box, index->point(segment),
+                                     index->point(segment + 1));
+    if (!clipped.has_value()) {
+      continue;
+    }
+    // отрезок продолжает ломаную, если начинается там, где она кончилась
+    if (!route_polyline.has_value() || polyline_end != segment ||
+        clipped->from_clipped) {
+      if (route_polyline.has_value()) {
+        doc.Add(*route_polyline);
+      }
+      route_polyline = createDefaultRoute_().SetStrokeColor(
+          settings_.paletteColor(index->routeOfPoint(segment)));
+      route_polyline->AddPoint(clipped->from);
+    }
+    route_polyline->AddPoint(clipped->to);
+    polyline_end = clipped->to_clipped ? std::nullopt
+                                       : std::optional<uint32_t>(segment + 1);
+  }
+  if (route_polyline.has_value()) {
+    doc.Add(*route_polyline);
+  }
+
+  // СЛОЙ 2. Названия маршрутов
+  for (const uint32_t label_index : content.labels) {
+    const TileIndex::RouteLabel &label = index->label(label_index);
+    addRouteName_(doc, index->route(label.route).name, label.position,
+                  settings_.paletteColor(label.route));
+  }
+
+  // СЛОЙ 3. Круги, обозначающие остановки
+  for (const uint32_t stop_index : content.stops) {
+    doc.Add(svg::Circle()
+                .SetCenter(index->stop(stop_index).position)
+                .SetRadius(settings_.stopRadius())
+                .SetFillColor("white"));
+  }
+
+  // СЛОЙ 4. Названия остановок
+  for (const uint32_t stop_index : content.stops) {
+    const TileIndex::Stop &stop = index->stop(stop_index);
+    addStopName_(doc, stop.name, stop.position);
+  }
+  doc.Close();
+  return std::make_shared<const std::string>(str_stream.Release());
+}
+
+std::shared_ptr<const std::string>
+MapRenderer_impl::renderTile(const TransportCatalogue &catalogue,
+                             TileAddress address) const {
+  const auto box = MakeTileBox(address, settings_.width(), settings_.height());
+  if (!box.has_value()) {
+    return nullptr;
+  }
+  return renderTile(catalogue, box.value());
 }
 
 std::unique_ptr<MapRenderer> MapRenderer::Make() {
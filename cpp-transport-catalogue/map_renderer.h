@@ -3,9 +3,15 @@
 #include "svg.h"
 #include "domain.h"
 #include "geo.h"
+#include "map_tiles.h"
+#include "transport_catalogue.h"
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <vector>
 
 inline constexpr double EPSILON = 1e-6;
@@ -88,7 +94,26 @@ public:
   virtual void SetSettings(const renderer::RenderSettings &) = 0;
   [[nodiscard]] virtual bool hasSettings() = 0;
   [[nodiscard]] virtual svg::Document
-  renderRoutesMap(const std::vector<BusInfo> &bus_info) const = 0;
+  renderRoutesMap(const TransportCatalogue::RoutesView &routes) const = 0;
+  // Потоковый вариант: слои выводятся в out по мере построения, без
+  // промежуточного svg::Document
+  virtual void renderRoutesMap(const TransportCatalogue::RoutesView &routes,
+                               std::ostream &out) const = 0;
+  // Карта справочника в SVG; nullptr - в справочнике нет маршрутов. Готовая
+  // карта хранится до изменения справочника или настроек, все ответы
+  // разделяют одну строку
+  [[nodiscard]] virtual std::shared_ptr<const std::string>
+  renderMap(const TransportCatalogue &catalogue) const = 0;
+  // Фрагмент карты: SVG с областью просмотра box в координатах полной карты.
+  // Выводятся только объекты, пересекающие box, ломаные обрезаются по его
+  // краям. nullptr - в справочнике нет маршрутов
+  [[nodiscard]] virtual std::shared_ptr<const std::string>
+  renderTile(const TransportCatalogue &catalogue,
+             const renderer::TileBox &box) const = 0;
+  // То же для плитки zoom/x/y; nullptr и для адреса за пределами холста
+  [[nodiscard]] virtual std::shared_ptr<const std::string>
+  renderTile(const TransportCatalogue &catalogue,
+             renderer::TileAddress address) const = 0;
 
   static std::unique_ptr<MapRenderer> Make();
 };
@@ -98,9 +123,35 @@ public:
   void SetSettings(const renderer::RenderSettings &) override;
   [[nodiscard]] bool hasSettings() override;
   [[nodiscard]] svg::Document
-  renderRoutesMap(const std::vector<BusInfo> &bus_info) const override;
+  renderRoutesMap(const TransportCatalogue::RoutesView &routes) const override;
+  void renderRoutesMap(const TransportCatalogue::RoutesView &routes,
+                       std::ostream &out) const override;
+  [[nodiscard]] std::shared_ptr<const std::string>
+  renderMap(const TransportCatalogue &catalogue) const override;
+  [[nodiscard]] std::shared_ptr<const std::string>
+  renderTile(const TransportCatalogue &catalogue,
+             const renderer::TileBox &box) const override;
+  [[nodiscard]] std::shared_ptr<const std::string>
+  renderTile(const TransportCatalogue &catalogue,
+             renderer::TileAddress address) const override;
 
 private:
+  // Строит слои карты в Container: svg::Document или svg::StreamDocument
+  template <typename Container>
+  void renderLayers_(const TransportCatalogue::RoutesView &routes,
+                     Container &doc) const;
+  // Надпись с названием маршрута и подложка под ней
+  template <typename Container>
+  void addRouteName_(Container &doc, std::string_view name,
+                     svg::Point position, const svg::Color &color) const;
+  // Надпись с названием остановки и подложка под ней
+  template <typename Container>
+  void addStopName_(Container &doc, std::string_view name,
+                    svg::Point position) const;
+  // Индекс плиток для текущего поколения справочника; nullptr - нет маршрутов
+  std::shared_ptr<const renderer::TileIndex>
+  tileIndex_(const TransportCatalogue &catalogue) const;
+
   svg::Polyline createDefaultRoute_() const;
   svg::Text createDefaultRouteName_() const;
   svg::Text createDefaultRouteName_underlayer_() const;
@@ -108,6 +159,23 @@ private:
   svg::Text createDefaultStopName_underlayer_() const;
 
   renderer::RenderSettings settings_{};
-  std::vector<BusInfo> bus_routes_{};
+
+  // последняя построенная карта и поколение справочника, по которому она
+  // построена. Запросы карты выполняются параллельно, поэтому кэш под мьютексом
+  struct MapCache {
+    uint64_t generation{};
+    std::shared_ptr<const std::string> svg{};
+  };
+  mutable std::mutex cache_mutex_;
+  mutable MapCache cache_{};
+
+  // индекс плиток строится при первом запросе плитки и живёт, как и карта,
+  // до изменения справочника или настроек. Сами плитки не кэшируются
+  struct TileIndexCache {
+    uint64_t generation{};
+    std::shared_ptr<const renderer::TileIndex> index{};
+  };
+  mutable std::mutex tile_mutex_;
+  mutable TileIndexCache tile_cache_{};
 };
 } // namespace transport
@@ -0,0 +1,286 @@
+#include "map_tiles.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+
+using namespace std;
+using namespace transport::renderer;
+
+namespace {
+// в среднем объектов на ячейку самого мелкого уровня и предельное число
+// уровней (у последнего 2048 ячеек по стороне)
+inline constexpr size_t GRID_ITEMS_PER_CELL = 4;
+inline constexpr size_t GRID_MAX_LEVELS = 12;
+} // namespace
+
+/*------------------------------ TileBox ----------------------------------*/
+bool TileBox::Intersects(const TileBox &other) const {
+  return min_x <= other.max_x && other.min_x <= max_x &&
+         min_y <= other.max_y && other.min_y <= max_y;
+}
+
+TileBox TileBox::Expanded(double margin) const {
+  return {min_x - margin, min_y - margin, max_x + margin, max_y + margin};
+}
+
+std::optional<TileBox>
+transport::renderer::MakeTileBox(TileAddress address, double width,
+                                 double height) {
+  if (address.zoom > MAX_TILE_ZOOM) {
+    return nullopt;
+  }
+  const uint64_t side = uint64_t{1} << address.zoom;
+  if (address.x >= side || address.y >= side) {
+    return nullopt;
+  }
+  const double tile_width = width / static_cast<double>(side);
+  const double tile_height = height / static_cast<double>(side);
+  return TileBox{static_cast<double>(address.x) * tile_width,
+                 static_cast<double>(address.y) * tile_height,
+                 static_cast<double>(address.x + 1) * tile_width,
+                 static_cast<double>(address.y + 1) * tile_height};
+}
+
+std::optional<ClippedSegment>
+transport::renderer::ClipSegment(const TileBox &box, svg::Point from,
+                                 svg::Point to) {
+  const double dx = to.x - from.x;
+  const double dy = to.y - from.y;
+  // параметры входа и выхода на отрезке from + t * (to - from)
+  double t_enter = 0.;
+  double t_exit = 1.;
+  // p * t <= q для каждой из четырёх границ
+  const array<pair<double, double>, 4> bounds{{{-dx, from.x - box.min_x},
+                                               {dx, box.max_x - from.x},
+                                               {-dy, from.y - box.min_y},
+                                               {dy, box.max_y - from.y}}};
+  for (const auto &[p, q] : bounds) {
+    if (p < 0.) {
+      t_enter = max(t_enter, q / p);
+    } else if (p > 0.) {
+      t_exit = min(t_exit, q / p);
+    } else if (q < 0.) {
+      // отрезок параллелен границе и лежит снаружи
+      return nullopt;
+    }
+    if (t_enter > t_exit) {
+      return nullopt;
+    }
+  }
+  ClippedSegment result{from, to, t_enter > 0., t_exit < 1.};
+  if (result.from_clipped) {
+    result.from = {from.x + t_enter * dx, from.y + t_enter * dy};
+  }
+  if (result.to_clipped) {
+    result.to = {from.x + t_exit * dx, from.y + t_exit * dy};
+  }
+  return result;
+}
+
+/*------------------------------ GridIndex --------------------------------*/
+void GridIndex::Build(const std::vector<TileBox> &boxes, double width,
+                      double height) {
+  // самый мелкий уровень такой, чтобы в ячейке было в среднем несколько
+  // объектов
+  const double cells = static_cast<double>(boxes.size()) / GRID_ITEMS_PER_CELL;
+  size_t level_count = 1;
+  while (level_count < GRID_MAX_LEVELS &&
+         static_cast<double>(size_t{1} << (2 * (level_count - 1))) < cells) {
+    ++level_count;
+  }
+  levels_.assign(level_count, {});
+  for (size_t level = 0; level < level_count; ++level) {
+    Level &grid = levels_[level];
+    grid.side = size_t{1} << level;
+    grid.cell_width = width > 0. ? width / static_cast<double>(grid.side) : 1.;
+    grid.cell_height =
+        height > 0. ? height / static_cast<double>(grid.side) : 1.;
+    grid.offsets.assign(grid.side * grid.side + 1, 0);
+  }
+
+  // два прохода: подсчёт объектов в ячейках, затем раскладка
+  const auto for_each_cell = [](const Level &grid, const TileBox &box,
+                                auto action) {
+    const auto [first_column, last_column] =
+        cellRange_(box.min_x, box.max_x, grid.cell_width, grid.side);
+    const auto [first_row, last_row] =
+        cellRange_(box.min_y, box.max_y, grid.cell_height, grid.side);
+    for (size_t row = first_row; row <= last_row; ++row) {
+      for (size_t column = first_column; column <= last_column; ++column) {
+        action(row * grid.side + column);
+      }
+    }
+  };
+  std::vector<uint8_t> box_levels;
+  box_levels.reserve(boxes.size());
+  for (const TileBox &box : boxes) {
+    box_levels.push_back(static_cast<uint8_t>(levelOf_(box)));
+    Level &grid = levels_[box_levels.back()];
+    for_each_cell(grid, box,
+                  [&grid](size_t cell) { ++grid.offsets[cell + 1]; });
+  }
+  std::vector<std::vector<uint32_t>> filled;
+  filled.reserve(level_count);
+  for (Level &grid : levels_) {
+    partial_sum(grid.offsets.begin(), grid.offsets.end(), grid.offsets.begin());
+    grid.items.resize(grid.offsets.back());
+    filled.emplace_back(grid.offsets.begin(), prev(grid.offsets.end()));
+  }
+  for (size_t index = 0; index < boxes.size(); ++index) {
+    Level &grid = levels_[box_levels[index]];
+    std::vector<uint32_t> &level_filled = filled[box_levels[index]];
+    for_each_cell(grid, boxes[index], [&](size_t cell) {
+      grid.items[level_filled[cell]++] = static_cast<uint32_t>(index);
+    });
+  }
+}
+
+void GridIndex::Query(const TileBox &box,
+                      std::vector<uint32_t> &result) const {
+  result.clear();
+  for (const Level &grid : levels_) {
+    const auto [first_column, last_column] =
+        cellRange_(box.min_x, box.max_x, grid.cell_width, grid.side);
+    const auto [first_row, last_row] =
+        cellRange_(box.min_y, box.max_y, grid.cell_height, grid.side);
+    for (size_t row = first_row; row <= last_row; ++row) {
+      const size_t first_cell = row * grid.side + first_column;
+      const size_t last_cell = row * grid.side + last_column;
+      result.insert(result.end(), grid.items.begin() + grid.offsets[first_cell],
+                    grid.items.begin() + grid.offsets[last_cell + 1]);
+    }
+  }
+  // объект на границе ячеек попадает в результат несколько раз
+  sort(result.begin(), result.end());
+  result.erase(unique(result.begin(), result.end()), result.end());
+}
+
+size_t GridIndex::levelOf_(const TileBox &box) const {
+  // с мелкого уровня к крупному, пока прямоугольник больше ячейки;
+  // прямоугольник больше холста остаётся на нулевом уровне
+  size_t level = levels_.size() - 1;
+  while (level > 0 && (box.max_x - box.min_x > levels_[level].cell_width ||
+                       box.max_y - box.min_y > levels_[level].cell_height)) {
+    --level;
+  }
+  return level;
+}
+
+std::pair<size_t, size_t> GridIndex::cellRange_(double min, double max,
+                                                double cell_size,
+                                                size_t count) {
+  // объекты за краем холста относятся к крайним ячейкам
+  const auto cell = [cell_size, count](double coordinate) {
+    const double position = std::floor(coordinate / cell_size);
+    if (!(position > 0.)) {
+      return size_t{0};
+    }
+    return std::min(static_cast<size_t>(position), count - 1);
+  };
+  return {cell(min), cell(max)};
+}
+
+/*------------------------------ TileIndex --------------------------------*/
+TileIndex::TileIndex(double width, double height)
+    : width_(width), height_(height) {}
+
+void TileIndex::AddRoute(std::string_view name) {
+  routes_.push_back({name, static_cast<uint32_t>(points_.size()), 0});
+}
+
+void TileIndex::AddPoint(svg::Point point) {
+  points_.push_back(point);
+  ++routes_.back().point_count;
+}
+
+void TileIndex::AddRouteLabel(svg::Point position, const TileBox &box) {
+  labels_.push_back({static_cast<uint32_t>(routes_.size() - 1), position});
+  label_boxes_.push_back(box);
+}
+
+void TileIndex::AddStop(std::string_view name, svg::Point position,
+                        const TileBox &box) {
+  stops_.push_back({name, position});
+  stop_boxes_.push_back(box);
+}
+
+void TileIndex::Build(double line_width) {
+  line_width_ = line_width;
+  // у последней вершины маршрута отрезка нет, её прямоугольник пустой и
+  // лежит в одной ячейке; при поиске такие номера отбрасываются
+  std::vector<TileBox> segment_boxes;
+  segment_boxes.reserve(points_.size());
+  for (uint32_t index = 0; index < points_.size(); ++index) {
+    segment_boxes.push_back(isSegment_(index)
+                                ? segmentBox_(index)
+                                : TileBox{points_[index].x, points_[index].y,
+                                          points_[index].x, points_[index].y});
+  }
+  segment_grid_.Build(segment_boxes, width_, height_);
+  label_grid_.Build(label_boxes_, width_, height_);
+  stop_grid_.Build(stop_boxes_, width_, height_);
+}
+
+TileIndex::Content TileIndex::Find(const TileBox &box) const {
+  Content result;
+  segment_grid_.Query(box, result.segments);
+  result.segments.erase(
+      remove_if(result.segments.begin(), result.segments.end(),
+                [&](uint32_t point) {
+                  return !isSegment_(point) ||
+                         !segmentBox_(point).Intersects(box);
+                }),
+      result.segments.end());
+  label_grid_.Query(box, result.labels);
+  result.labels.erase(remove_if(result.labels.begin(), result.labels.end(),
+                                [&](uint32_t label) {
+                                  return !label_boxes_[label].Intersects(box);
+                                }),
+                      result.labels.end());
+  stop_grid_.Query(box, result.stops);
+  result.stops.erase(remove_if(result.stops.begin(), result.stops.end(),
+                               [&](uint32_t stop) {
+                                 return !stop_boxes_[stop].Intersects(box);
+                               }),
+                     result.stops.end());
+  return result;
+}
+
+const TileIndex::Route &TileIndex::route(size_t index) const {
+  return routes_[index];
+}
+
+size_t TileIndex::routeOfPoint(uint32_t point) const {
+  const auto iter = upper_bound(
+      routes_.begin(), routes_.end(), point,
+      [](uint32_t value, const Route &route) {
+        return value < route.first_point;
+      });
+  return static_cast<size_t>(distance(routes_.begin(), iter)) - 1;
+}
+
+svg::Point TileIndex::point(size_t index) const { return points_[index]; }
+
+const TileIndex::RouteLabel &TileIndex::label(size_t index) const {
+  return labels_[index];
+}
+
+const TileIndex::Stop &TileIndex::stop(size_t index) const {
+  return stops_[index];
+}
+
+bool TileIndex::isSegment_(uint32_t point) const {
+  const Route &owner = routes_[routeOfPoint(point)];
+  return point + 1 < owner.first_point + owner.point_count;
+}
+
+TileBox TileIndex::segmentBox_(uint32_t point) const {
+  const svg::Point from = points_[point];
+  const svg::Point to = points_[point + 1];
+  return TileBox{min(from.x, to.x), min(from.y, to.y), max(from.x, to.x),
+                 max(from.y, to.y)}
+      .Expanded(line_width_ / 2);
+}
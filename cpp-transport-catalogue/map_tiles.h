@@ -0,0 +1,153 @@
+#pragma once
+
+#include "svg.h"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace transport::renderer {
+
+/* --------------- Фрагменты карты ----------------------------------------- */
+// Прямоугольник в координатах холста карты
+struct TileBox {
+  double min_x{};
+  double min_y{};
+  double max_x{};
+  double max_y{};
+
+  [[nodiscard]] bool Intersects(const TileBox &other) const;
+  // Прямоугольник, расширенный на margin во все стороны
+  [[nodiscard]] TileBox Expanded(double margin) const;
+};
+
+// Адрес плитки: холст делится на 2^zoom x 2^zoom равных частей, x и y -
+// номера столбца и строки от левого верхнего угла
+struct TileAddress {
+  uint32_t zoom{};
+  uint32_t x{};
+  uint32_t y{};
+};
+
+inline constexpr uint32_t MAX_TILE_ZOOM = 30;
+
+// Прямоугольник плитки на холсте width x height; nullopt - адрес вне холста
+std::optional<TileBox> MakeTileBox(TileAddress address, double width,
+                                   double height);
+
+// Часть отрезка внутри прямоугольника и признаки того, что концы обрезаны
+struct ClippedSegment {
+  svg::Point from;
+  svg::Point to;
+  bool from_clipped;
+  bool to_clipped;
+};
+
+// Обрезает отрезок [from, to] по прямоугольнику box (алгоритм Лианга -
+// Барски). nullopt - отрезок целиком снаружи
+std::optional<ClippedSegment> ClipSegment(const TileBox &box, svg::Point from,
+                                          svg::Point to);
+
+// Иерархическая сетка над холстом: уровень l делит холст на 2^l x 2^l
+// ячеек. Объект хранится на самом мелком уровне, где его охватывающий
+// прямоугольник не больше ячейки, и попадает не более чем в четыре ячейки,
+// поэтому длинные отрезки не размножаются по всей сетке. Ячейки уровня лежат
+// подряд в одном массиве (offsets - начало каждой ячейки в items)
+class GridIndex {
+public:
+  // boxes[i] - прямоугольник объекта с номером i
+  void Build(const std::vector<TileBox> &boxes, double width, double height);
+
+  // Номера объектов из ячеек, пересекающих box, по возрастанию и без
+  // повторов. Проверку самих прямоугольников выполняет вызывающий
+  void Query(const TileBox &box, std::vector<uint32_t> &result) const;
+
+private:
+  struct Level {
+    size_t side{};
+    double cell_width{1.};
+    double cell_height{1.};
+    std::vector<uint32_t> offsets{};
+    std::vector<uint32_t> items{};
+  };
+  std::vector<Level> levels_{};
+
+  // уровень для прямоугольника box
+  [[nodiscard]] size_t levelOf_(const TileBox &box) const;
+  // диапазон ячеек [first, last] по одной оси
+  [[nodiscard]] static std::pair<size_t, size_t>
+  cellRange_(double min, double max, double cell_size, size_t count);
+};
+
+// Спроецированная карта с пространственным индексом для выдачи плиток.
+// Наполняется в порядке вывода полной карты: маршруты по названию, затем
+// остановки по названию, после чего вызывается Build
+class TileIndex {
+public:
+  struct Route {
+    std::string_view name;
+    // вершины ломаной - points_[first_point, first_point + point_count)
+    uint32_t first_point;
+    uint32_t point_count;
+  };
+
+  // Надпись с названием маршрута у конечной остановки
+  struct RouteLabel {
+    uint32_t route;
+    svg::Point position;
+  };
+
+  struct Stop {
+    std::string_view name;
+    svg::Point position;
+  };
+
+  // Видимые объекты плитки по возрастанию номеров, то есть в порядке вывода
+  struct Content {
+    // номер отрезка - номер его первой вершины в points
+    std::vector<uint32_t> segments;
+    std::vector<uint32_t> labels;
+    std::vector<uint32_t> stops;
+  };
+
+  TileIndex(double width, double height);
+
+  // Новый маршрут; его вершины добавляются следующими AddPoint
+  void AddRoute(std::string_view name);
+  void AddPoint(svg::Point point);
+  // box - оценка области надписи
+  void AddRouteLabel(svg::Point position, const TileBox &box);
+  // box - область круга и надписи остановки
+  void AddStop(std::string_view name, svg::Point position, const TileBox &box);
+  // Строит сетки; отрезки расширяются на половину толщины линии
+  void Build(double line_width);
+
+  [[nodiscard]] Content Find(const TileBox &box) const;
+
+  [[nodiscard]] const Route &route(size_t index) const;
+  // номер маршрута, которому принадлежит вершина
+  [[nodiscard]] size_t routeOfPoint(uint32_t point) const;
+  [[nodiscard]] svg::Point point(size_t index) const;
+  [[nodiscard]] const RouteLabel &label(size_t index) const;
+  [[nodiscard]] const Stop &stop(size_t index) const;
+
+private:
+  double width_;
+  double height_;
+  double line_width_{};
+  std::vector<Route> routes_{};
+  std::vector<svg::Point> points_{};
+  std::vector<RouteLabel> labels_{};
+  std::vector<TileBox> label_boxes_{};
+  std::vector<Stop> stops_{};
+  std::vector<TileBox> stop_boxes_{};
+  GridIndex segment_grid_{};
+  GridIndex label_grid_{};
+  GridIndex stop_grid_{};
+
+  [[nodiscard]] bool isSegment_(uint32_t point) const;
+  [[nodiscard]] TileBox segmentBox_(uint32_t point) const;
+};
+
+} // namespace transport::renderer
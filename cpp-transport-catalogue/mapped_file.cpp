@@ -0,0 +1,69 @@
+#include "mapped_file.h"
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace io {
+
+MappedFile::MappedFile(const std::string &path) {
+  const int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) {
+    throw runtime_error("Can't open file " + path);
+  }
+  struct stat file_stat {};
+  if (fstat(descriptor, &file_stat) != 0 || file_stat.st_size <= 0) {
+    close(descriptor);
+    throw runtime_error("Can't map empty or unreadable file " + path);
+  }
+  const auto size = static_cast<size_t>(file_stat.st_size);
+  void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  // отображение не зависит от дескриптора
+  close(descriptor);
+  if (address == MAP_FAILED) {
+    throw runtime_error("Can't map file " + path);
+  }
+  data_ = static_cast<const std::byte *>(address);
+  size_ = size;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data_(exchange(other.data_, nullptr)), size_(exchange(other.size_, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    Unmap();
+    data_ = exchange(other.data_, nullptr);
+    size_ = exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() { Unmap(); }
+
+const std::byte *MappedFile::GetData() const { return data_; }
+
+size_t MappedFile::GetSize() const { return size_; }
+
+void WriteAt(std::ostream &out, size_t offset, const void *data,
+             size_t size) {
+  while (static_cast<size_t>(out.tellp()) < offset) {
+    out.put('\0');
+  }
+  out.write(static_cast<const char *>(data), static_cast<streamsize>(size));
+}
+
+void MappedFile::Unmap() {
+  if (data_ != nullptr) {
+    munmap(const_cast<std::byte *>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+} // namespace io
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace io {
+
+// Файл, отображённый в память только для чтения. Отображение живёт, пока жив
+// объект; при ошибке открытия или отображения конструктор бросает
+// std::runtime_error
+class MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &path);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  ~MappedFile();
+
+  [[nodiscard]] const std::byte *GetData() const;
+  [[nodiscard]] size_t GetSize() const;
+
+private:
+  void Unmap();
+
+  const std::byte *data_{nullptr};
+  size_t size_{};
+};
+
+// Выравнивает смещение в файле вверх до границы alignment
+constexpr size_t AlignOffset(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Записывает size байт data в поток по смещению offset не меньше текущего,
+// заполняя промежуток нулями
+void WriteAt(std::ostream &out, size_t offset, const void *data, size_t size);
+
+} // namespace io
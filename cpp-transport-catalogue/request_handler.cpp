@@ -1,29 +1,110 @@
 #include "request_handler.h"
 #include "json_reader.h"
+#include "string_pool.h"
 
+#include <tbb/parallel_for.h>
+
+#include <iostream>
 #include <ostream>
+#include <type_traits>
 #include <utility>
 
 using namespace std;
 using namespace transport;
 using namespace transport::detail;
 
+namespace {
+// число запросов в пачке параллельного выполнения: ответы пачки хранятся до
+// вывода, поэтому память ограничена размером пачки, а не числом запросов
+inline constexpr size_t PARALLEL_BATCH_SIZE = 4096;
+
+// Посетитель одного запроса при параллельном выполнении: предоставляет ресурсы
+// обработчика и сохраняет ответ в отведённую запросу ячейку
+class ResponseSlot final : public QueryVisitor {
+public:
+  ResponseSlot(const QueryVisitor &resources, uniqueResponse &slot)
+      : resources_(resources), slot_(slot) {}
+
+  [[nodiscard]] TransportCatalogue *getCatalog() const override {
+    return resources_.getCatalog();
+  }
+  [[nodiscard]] MapRenderer *getRenderer() const override {
+    return resources_.getRenderer();
+  }
+  [[nodiscard]] TransportRouter *getRouter() const override {
+    return resources_.getRouter();
+  }
+  void appendResponse(uniqueResponse response) override {
+    slot_ = move(response);
+  }
+
+private:
+  const QueryVisitor &resources_;
+  uniqueResponse &slot_;
+};
+} // namespace
+
 void transport::RequestHandler::Execute() {
   if (inputter_ == nullptr) {
     return;
   }
   // получаю на обработку запросы из входног потока
   inputter_->Parse();
-  for (const auto &query : *inputter_) {
-    query->Execute(*this);
+  // запросы после последнего изменяющего выполняются параллельно
+  auto tail = inputter_->end();
+  while (tail != inputter_->begin() &&
+         dynamic_cast<const ComputeQuery *>(prev(tail)->get()) != nullptr) {
+    --tail;
+  }
+  for (auto iter = inputter_->begin(); iter != tail; ++iter) {
+    (*iter)->Execute(*this);
+  }
+  // справочник больше не меняется: статистика маршрутов считается заранее
+  if (tail != inputter_->end()) {
+    db_->finalize();
   }
+  std::vector<const ComputeQuery *> batch;
+  batch.reserve(PARALLEL_BATCH_SIZE);
+  for (auto iter = tail; iter != inputter_->end(); ++iter) {
+    batch.push_back(static_cast<const ComputeQuery *>(iter->get()));
+    if (batch.size() == PARALLEL_BATCH_SIZE) {
+      executeParallel_(batch);
+      batch.clear();
+    }
+  }
+  executeParallel_(batch);
   // готовый документ отгружаю в выходной поток
   outputter_->Send();
 }
 
+void RequestHandler::executeParallel_(
+    const std::vector<const ComputeQuery *> &queries) {
+  // общие ресурсы готовятся последовательно, дальше запросы их только читают
+  for (const ComputeQuery *query : queries) {
+    query->Prepare(*this);
+  }
+  std::vector<uniqueResponse> responses(queries.size());
+  tbb::parallel_for(size_t{0}, queries.size(), [&](size_t index) {
+    ResponseSlot slot(*this, responses[index]);
+    queries[index]->Compute(slot);
+  });
+  for (auto &response : responses) {
+    if (response != nullptr) {
+      appendResponse(move(response));
+    }
+  }
+}
+
 void ModifyQuery::Execute(QueryVisitor &visitor) const { Process(visitor); }
 
-void ComputeQuery::Execute(QueryVisitor &visitor) const { Process(visitor); }
+void ComputeQuery::Execute(QueryVisitor &visitor) const {
+  Prepare(visitor);
+  Process(visitor);
+}
+
+void ComputeQuery::Prepare(QueryVisitor & /*visitor*/) const {}
+
+void ComputeQuery::Compute(QueryVisitor &visitor) const { Process(visitor); }
 
 namespace transport::queries {
 
@@ -42,17 +123,27 @@ AddBusQuery::AddBusQuery(const BusData &data) : data_(data) {}
 void AddBusQuery::Process(QueryVisitor &visitor) const {
   if (nullptr != visitor.getCatalog()) {
     visitor.getCatalog()->addBus(data_);
+    // уже построенный граф маршрутов дополняется новым автобусом
+    if (nullptr != visitor.getRouter() && visitor.getRouter()->IsReady()) {
+      if (const auto bus_info = visitor.getCatalog()->getRouteInfo(data_.name);
+          bus_info.has_value()) {
+        visitor.getRouter()->UpdateBus(bus_info.value());
+      }
+    }
   }
 }
 
-AddBusQuery::Factory &AddBusQuery::Factory::SetName(const std::string &name) {
-  data_.name = name;
+AddBusQuery::Factory &AddBusQuery::Factory::SetName(std::string_view name) {
+  data_.name = detail::Intern(name);
   return *this;
 }
 
 AddBusQuery::Factory &
-AddBusQuery::Factory::SetStops(const std::vector<std::string> &stops) {
-  data_.stops = stops;
+AddBusQuery::Factory::SetStops(const std::vector<std::string_view> &stops) {
+  data_.stops.clear();
+  data_.stops.reserve(stops.size());
+  transform(stops.begin(), stops.end(), back_inserter(data_.stops),
+            detail::Intern);
   return *this;
 }
 
@@ -69,7 +160,7 @@ uniqueQuery AddBusQuery::Factory::Construct() const {
   return std::make_unique<AddBusQuery>(data_);
 }
 
-StatBusQuery::StatBusQuery(int requestId, const std::string &name)
+StatBusQuery::StatBusQuery(int requestId, std::string_view name)
     : id_(requestId), name_(name) {}
 
 void StatBusQuery::Process(QueryVisitor &visitor) const {
@@ -84,7 +175,7 @@ void StatBusQuery::Process(QueryVisitor &visitor) const {
   }
 }
 
-StatBusQuery::Factory &StatBusQuery::Factory::SetName(const std::string &name) {
+StatBusQuery::Factory &StatBusQuery::Factory::SetName(std::string_view name) {
   name_ = name;
   return *this;
 }
@@ -113,7 +204,7 @@ void StatResponse::accept(Outputter &outputter) { outputter.visit(this); }
 
 int StatResponse::getId() const { return id_; }
 
-string StatResponse::getName() const { return string(data_.name); }
+string_view StatResponse::getName() const { return data_.name; }
 
 uint StatResponse::getStopsCount() const { return data_.stops_count; }
 
@@ -132,11 +223,22 @@ AddStopQuery::AddStopQuery(const StopData &data) : data_(data) {}
 void AddStopQuery::Process(QueryVisitor &visitor) const {
   if (nullptr != visitor.getCatalog()) {
     visitor.getCatalog()->addStop(data_);
+    // расстояния от остановки могли измениться у всех автобусов через неё,
+    // а ожидавшие её автобусы - стать полными
+    if (nullptr != visitor.getRouter() && visitor.getRouter()->IsReady()) {
+      const auto stop_stat = visitor.getCatalog()->getStopStat(data_.name);
+      for (const auto &bus_name : stop_stat->buses) {
+        if (const auto bus_info = visitor.getCatalog()->getRouteInfo(bus_name);
+            bus_info.has_value()) {
+          visitor.getRouter()->UpdateBus(bus_info.value());
+        }
+      }
+    }
   }
 }
 
-AddStopQuery::Factory &AddStopQuery::Factory::SetName(const std::string &name) {
-  data_.name = name;
+AddStopQuery::Factory &AddStopQuery::Factory::SetName(std::string_view name) {
+  data_.name = detail::Intern(name);
   return *this;
 }
 
@@ -147,8 +249,11 @@ AddStopQuery::Factory &AddStopQuery::Factory::SetCoordinates(double latitude,
 }
 
 AddStopQuery::Factory &AddStopQuery::Factory::SetDistances(
-    std::map<std::string, double> road_distances) {
-  data_.road_distances.swap(road_distances);
+    const std::map<std::string_view, double> &road_distances) {
+  data_.road_distances.clear();
+  for (const auto &[stop_name, distance] : road_distances) {
+    data_.road_distances.emplace(detail::Intern(stop_name), distance);
+  }
   return *this;
 }
 
@@ -163,7 +268,7 @@ uniqueQuery AddStopQuery::Factory::Construct() const {
   return std::make_unique<AddStopQuery>(data_);
 }
 
-StatStopQuery::StatStopQuery(int requestId, const std::string &name)
+StatStopQuery::StatStopQuery(int requestId, std::string_view name)
     : id_(requestId), name_(name) {}
 
 void StatStopQuery::Process(QueryVisitor &visitor) const {
@@ -179,8 +284,7 @@ void StatStopQuery::Process(QueryVisitor &visitor) const {
   }
 }
 
-StatStopQuery::Factory &
-StatStopQuery::Factory::SetName(const std::string &name) {
+StatStopQuery::Factory &StatStopQuery::Factory::SetName(std::string_view name) {
   name_ = name;
   return *this;
 }
@@ -215,17 +319,19 @@ StatResponse::StatResponse(int id, const StopStat &data)
 
 int StatResponse::getId() const { return id_; }
 
-string StatResponse::getName() const { return data_.name; }
+string_view StatResponse::getName() const { return data_.name; }
 
-vector<string>::const_iterator StatResponse::buses_cbegin() const {
+vector<string_view>::const_iterator StatResponse::buses_cbegin() const {
   return data_.buses.cbegin();
 }
 
-vector<string>::const_iterator StatResponse::buses_cend() const {
+vector<string_view>::const_iterator StatResponse::buses_cend() const {
   return data_.buses.cend();
 }
 
-std::vector<string> StatResponse::getBuses() const { return data_.buses; }
+std::vector<string_view> StatResponse::getBuses() const {
+  return data_.buses;
+}
 
 void StatResponse::accept(Outputter &outputter) { outputter.visit(this); }
 
@@ -269,26 +375,75 @@ uniqueQuery MapRender::Factory::Construct() const {
 MapRender::MapRender(int requestId) : id_(requestId) {}
 
 void MapRender::Process(QueryVisitor &visitor) const {
-  if (nullptr == visitor.getCatalog() || nullptr == visitor.getRenderer()) {
+  // без настроек отрисовки (в том числе без палитры) карты нет
+  if (nullptr == visitor.getCatalog() || nullptr == visitor.getRenderer() ||
+      !visitor.getRenderer()->hasSettings()) {
     visitor.appendResponse(EmptyResponse::Factory().Construct(id_));
+    return;
   }
-  auto routes = visitor.getCatalog()->getRoutesInfo();
-  if (routes.has_value()) {
-    // Напинать рендер, что б поработал и вернул картинку
-    auto doc = visitor.getRenderer()->renderRoutesMap(routes.value());
-    std::ostringstream str_stream;
-    doc.Render(str_stream);
-    //    std::cout << str_stream.str();
+  // Напинать рендер, что б поработал и вернул картинку
+  if (auto map = visitor.getRenderer()->renderMap(*visitor.getCatalog());
+      map != nullptr) {
     visitor.appendResponse(
-        MapResponse::Factory().SetResponse(str_stream.str()).Construct(id_));
+        MapResponse::Factory().SetResponse(std::move(map)).Construct(id_));
+    return;
+  }
+  visitor.appendResponse(EmptyResponse::Factory().Construct(id_));
+}
+
+TileRender::Factory &TileRender::Factory::SetId(int requestId) {
+  id_ = requestId;
+  return *this;
+}
+
+TileRender::Factory &
+TileRender::Factory::SetAddress(renderer::TileAddress address) {
+  area_ = address;
+  return *this;
+}
+
+TileRender::Factory &
+TileRender::Factory::SetBox(const renderer::TileBox &box) {
+  area_ = box;
+  return *this;
+}
+
+uniqueQuery TileRender::Factory::Construct() const {
+  return std::make_unique<TileRender>(id_, area_);
+}
+
+TileRender::TileRender(int requestId, Area area)
+    : id_(requestId), area_(area) {}
+
+void TileRender::Process(QueryVisitor &visitor) const {
+  if (nullptr == visitor.getCatalog() || nullptr == visitor.getRenderer() ||
+      !visitor.getRenderer()->hasSettings()) {
+    visitor.appendResponse(EmptyResponse::Factory().Construct(id_));
+    return;
+  }
+  // неверная область, адрес вне холста или пустой справочник - пустой ответ
+  auto tile = std::visit(
+      [&visitor](const auto &area) -> std::shared_ptr<const std::string> {
+        if constexpr (std::is_same_v<std::decay_t<decltype(area)>,
+                                     std::monostate>) {
+          return nullptr;
+        } else {
+          return visitor.getRenderer()->renderTile(*visitor.getCatalog(),
+                                                   area);
+        }
+      },
+      area_);
+  if (tile != nullptr) {
+    visitor.appendResponse(
+        MapResponse::Factory().SetResponse(std::move(tile)).Construct(id_));
     return;
   }
   visitor.appendResponse(EmptyResponse::Factory().Construct(id_));
 }
 
 MapResponse::Factory &
-MapResponse::Factory::SetResponse(const std::string &data) {
-  data_ = data;
+MapResponse::Factory::SetResponse(std::shared_ptr<const std::string> data) {
+  data_ = move(data);
   return *this;
 }
 
@@ -296,16 +451,63 @@ std::unique_ptr<Response> MapResponse::Factory::Construct(int id) const {
   return std::make_unique<MapResponse>(id, data_);
 }
 
-MapResponse::MapResponse(int id, const string &data) : id_(id), data_(data) {}
+MapResponse::MapResponse(int id, std::shared_ptr<const std::string> data)
+    : id_(id), data_(move(data)) {}
 
 int MapResponse::getId() const { return id_; }
 
-string MapResponse::getMap() const { return data_; }
+const string &MapResponse::getMap() const { return *data_; }
 
 void MapResponse::accept(Outputter &outputter) { outputter.visit(this); }
 
 } // namespace map
 
+namespace serialization {
+SerializationSettings::SerializationSettings(const std::string &file,
+                                             Direction direction)
+    : file_(file), direction_(direction) {}
+
+SerializationSettings::Factory &
+SerializationSettings::Factory::SetFile(const std::string &file) {
+  file_ = file;
+  return *this;
+}
+
+SerializationSettings::Factory &
+SerializationSettings::Factory::SetDirection(Direction direction) {
+  direction_ = direction;
+  return *this;
+}
+
+uniqueQuery SerializationSettings::Factory::Construct() const {
+  if (file_.empty()) {
+    throw std::logic_error("Serialization file is not set");
+  }
+  return std::unique_ptr<Query>(new SerializationSettings(file_, direction_));
+}
+
+void SerializationSettings::Execute(QueryVisitor &visitor) const {
+  Process(visitor);
+}
+
+void SerializationSettings::Process(QueryVisitor &visitor) const {
+  if (nullptr == visitor.getCatalog()) {
+    return;
+  }
+  // снимка может ещё не быть или он повреждён: это не должно обрывать
+  // обработку остальных запросов
+  try {
+    if (Direction::LOAD == direction_) {
+      visitor.getCatalog()->loadSnapshot(file_);
+    } else {
+      visitor.getCatalog()->saveSnapshot(file_);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+} // namespace serialization
+
 namespace router {
 RoutingSettings::RoutingSettings(
     const transport::router::RoutingSettings &settings)
@@ -327,6 +529,24 @@ RoutingSettings::Factory::SetBusVelocity(double velocity) {
   return *this;
 }
 
+RoutingSettings::Factory &RoutingSettings::Factory::SetRouterMode(
+    transport::router::RouterMode mode) {
+  settings_.mode = mode;
+  return *this;
+}
+
+RoutingSettings::Factory &RoutingSettings::Factory::SetGraphModel(
+    transport::router::GraphModel model) {
+  settings_.graph_model = model;
+  return *this;
+}
+
+RoutingSettings::Factory &
+RoutingSettings::Factory::SetRouterFile(const std::string &file) {
+  settings_.router_file = file;
+  return *this;
+}
+
 uniqueQuery RoutingSettings::Factory::Construct() const {
   if (settings_.bus_wait < 1. || settings_.bus_velocity < 1.0) {
     throw std::logic_error("Routing settings are not valid");
@@ -348,12 +568,12 @@ RouteQuery::Factory &RouteQuery::Factory::SetId(int requestId) {
   return *this;
 }
 
-RouteQuery::Factory &RouteQuery::Factory::SetFromStop(const std::string &from) {
+RouteQuery::Factory &RouteQuery::Factory::SetFromStop(std::string_view from) {
   stop_from_ = from;
   return *this;
 }
 
-RouteQuery::Factory &RouteQuery::Factory::SetToStop(const std::string &to) {
+RouteQuery::Factory &RouteQuery::Factory::SetToStop(std::string_view to) {
   stop_to_ = to;
   return *this;
 }
@@ -368,22 +588,25 @@ uniqueQuery RouteQuery::Factory::Construct() const {
   return std::unique_ptr<Query>(new RouteQuery(id_, stop_from_, stop_to_));
 }
 
-RouteQuery::RouteQuery(int id, const std::string &stop_from,
-                       const std::string &stop_to)
+RouteQuery::RouteQuery(int id, std::string_view stop_from,
+                       std::string_view stop_to)
     : id_(id), stop_from_(stop_from), stop_to_(stop_to) {}
 
-void RouteQuery::Process(QueryVisitor &visitor) const {
-  //  if (nullptr == visitor.getCatalog() || nullptr == visitor.getRouter()) {
-  //    visitor.appendResponse(EmptyResponse::Factory().Construct(id_));
-  //  }
+void RouteQuery::Prepare(QueryVisitor &visitor) const {
+  // граф маршрутов строится при первом запросе маршрута
   if (!visitor.getRouter()->IsReady()) {
     const auto routes(visitor.getCatalog()->getRoutesInfo());
-    const auto distances(visitor.getCatalog()->getDistances());
     const size_t stops_count(visitor.getCatalog()->getStopCount());
     if (routes.has_value()) {
-      visitor.getRouter()->UploadData(stops_count, routes.value(), distances);
+      visitor.getRouter()->UploadData(stops_count, routes.value());
     }
   }
+}
+
+void RouteQuery::Process(QueryVisitor &visitor) const {
+  //  if (nullptr == visitor.getCatalog() || nullptr == visitor.getRouter()) {
+  //    visitor.appendResponse(EmptyResponse::Factory().Construct(id_));
+  //  }
   if (visitor.getRouter()->IsReady()) {
     auto result(visitor.getRouter()->FindRoute(stop_from_, stop_to_));
     if (result.has_value()) {
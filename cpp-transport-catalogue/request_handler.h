@@ -7,7 +7,10 @@
 #include "transport_router.h"
 #include <list>
 #include <memory>
+#include <string>
 #include <unordered_set>
+#include <variant>
+#include <vector>
 
 namespace transport {
 /* Класс RequestHandler организует совместную работу TransportCatalog, Renderer
@@ -123,7 +126,9 @@ public:
 
 // Абстрактный базовый класс запроса.
 // Реализации хранят данные запроса и умеют его выполнять используя
-// переданные посетителем рессурсы
+// переданные посетителем рессурсы. Названия, которые попадут в справочник,
+// помещаются в пул строк; названия, которые в нём только ищутся, запрос
+// хранит сам, не пополняя пул
 class Query {
 public:
   virtual ~Query() = default;
@@ -152,12 +157,21 @@ protected:
   virtual void Process(QueryVisitor &visitor) const = 0;
 };
 
+// ComputeQuery только читает ресурсы посетителя, поэтому такие запросы после
+// последнего ModifyQuery выполняются параллельно. Изменение общих ресурсов,
+// нужное запросу (например, построение графа маршрутов), выносится в Prepare,
+// который вызывается последовательно перед Process
 class ComputeQuery : public Query {
 public:
   using Query::Query;
   //  ComputeQuery();
   ~ComputeQuery() override = default;
+  // Prepare и Process подряд
   void Execute(QueryVisitor &visitor) const override;
+  // подготовка общих ресурсов, по умолчанию ничего не делает
+  virtual void Prepare(QueryVisitor &visitor) const;
+  // только Process; можно вызывать одновременно из нескольких потоков
+  void Compute(QueryVisitor &visitor) const;
 
 protected:
   virtual void Process(QueryVisitor &visitor) const = 0;
@@ -192,8 +206,9 @@ public:
   class Factory : public QueryFactory {
   public:
     using QueryFactory::QueryFactory;
-    Factory &SetName(const std::string &name);
-    Factory &SetStops(const std::vector<std::string> &stops);
+    // названия помещаются в пул строк
+    Factory &SetName(std::string_view name);
+    Factory &SetStops(const std::vector<std::string_view> &stops);
     Factory &SetRoundTripMark(bool is_roundtrip);
     [[nodiscard]] uniqueQuery Construct() const override;
 
@@ -214,7 +229,7 @@ public:
   StatResponse(int id, const BusStat &data);
   void accept(Outputter &outputter) override;
   [[nodiscard]] int getId() const;
-  [[nodiscard]] std::string getName() const;
+  [[nodiscard]] std::string_view getName() const;
   [[nodiscard]] uint getStopsCount() const;
   [[nodiscard]] uint getUniqueStopsCount() const;
   [[nodiscard]] double getGeoLength() const;
@@ -237,12 +252,12 @@ private:
 class StatBusQuery final : public ComputeQuery {
 public:
   using ComputeQuery::ComputeQuery;
-  StatBusQuery(int requestId, const std::string &name);
+  StatBusQuery(int requestId, std::string_view name);
 
   class Factory : public QueryFactory {
   public:
     using QueryFactory::QueryFactory;
-    Factory &SetName(const std::string &name);
+    Factory &SetName(std::string_view name);
     Factory &SetId(int requestId);
     [[nodiscard]] uniqueQuery Construct() const override;
 
@@ -269,9 +284,11 @@ public:
   class Factory : public QueryFactory {
   public:
     using QueryFactory::QueryFactory;
-    Factory &SetName(const std::string &name);
+    // названия помещаются в пул строк
+    Factory &SetName(std::string_view name);
     Factory &SetCoordinates(double latitude, double longitude);
-    Factory &SetDistances(std::map<std::string, double> road_distances);
+    Factory &SetDistances(
+        const std::map<std::string_view, double> &road_distances);
 
     [[nodiscard]] uniqueQuery Construct() const override;
 
@@ -293,10 +310,12 @@ public:
   StatResponse(int id, const StopStat &data);
   void accept(Outputter &outputter) override;
   [[nodiscard]] int getId() const;
-  [[nodiscard]] std::string getName() const;
-  [[nodiscard]] std::vector<std::string>::const_iterator buses_cbegin() const;
-  [[nodiscard]] std::vector<std::string>::const_iterator buses_cend() const;
-  [[nodiscard]] std::vector<std::string> getBuses() const;
+  [[nodiscard]] std::string_view getName() const;
+  [[nodiscard]] std::vector<std::string_view>::const_iterator
+  buses_cbegin() const;
+  [[nodiscard]] std::vector<std::string_view>::const_iterator
+  buses_cend() const;
+  [[nodiscard]] std::vector<std::string_view> getBuses() const;
 
   class Factory : public ResponseFactory {
   public:
@@ -316,12 +335,12 @@ private:
 class StatStopQuery final : public ComputeQuery {
 public:
   using ComputeQuery::ComputeQuery;
-  StatStopQuery(int requestId, const std::string &name);
+  StatStopQuery(int requestId, std::string_view name);
 
   class Factory : public QueryFactory {
   public:
     using QueryFactory::QueryFactory;
-    Factory &SetName(const std::string &name);
+    Factory &SetName(std::string_view name);
     Factory &SetId(int requestId);
     [[nodiscard]] uniqueQuery Construct() const override;
 
@@ -366,24 +385,25 @@ private:
 class MapResponse final : public Response {
 public:
   using Response::Response;
-  MapResponse(int id, const std::string &data);
+  MapResponse(int id, std::shared_ptr<const std::string> data);
   void accept(Outputter &outputter) override;
   [[nodiscard]] int getId() const;
-  [[nodiscard]] std::string getMap() const;
+  [[nodiscard]] const std::string &getMap() const;
 
   class Factory : public ResponseFactory {
   public:
     using ResponseFactory::ResponseFactory;
-    Factory &SetResponse(const std::string &data);
+    Factory &SetResponse(std::shared_ptr<const std::string> data);
     [[nodiscard]] std::unique_ptr<Response> Construct(int id) const override;
 
   private:
-    std::string data_;
+    std::shared_ptr<const std::string> data_;
   };
 
 private:
   int id_;
-  std::string data_;
+  // строка карты общая с кэшем рендера и другими ответами
+  std::shared_ptr<const std::string> data_;
 };
 
 class MapRender final : public ComputeQuery {
@@ -407,8 +427,72 @@ protected:
 private:
   int id_;
 };
+
+// Фрагмент карты: плитка по адресу zoom/x/y или произвольный прямоугольник
+// холста. Ответ - тот же MapResponse, только с видимыми объектами. Запрос с
+// неверной областью (std::monostate) получает ответ "not found"
+class TileRender final : public ComputeQuery {
+public:
+  using Area =
+      std::variant<std::monostate, renderer::TileAddress, renderer::TileBox>;
+  using ComputeQuery::ComputeQuery;
+  TileRender(int requestId, Area area);
+
+  class Factory : public QueryFactory {
+  public:
+    using QueryFactory::QueryFactory;
+    Factory &SetId(int requestId);
+    Factory &SetAddress(renderer::TileAddress address);
+    Factory &SetBox(const renderer::TileBox &box);
+    [[nodiscard]] uniqueQuery Construct() const override;
+
+  private:
+    int id_;
+    Area area_;
+  };
+
+protected:
+  void Process(QueryVisitor &visitor) const override;
+
+private:
+  int id_;
+  Area area_;
+};
 } // namespace map
 
+namespace serialization {
+// Снимок справочника. Направление задаёт разборщик входа: при наличии раздела
+// base_requests снимок записывается после них (SAVE), без него справочник
+// загружается из снимка (LOAD). Ошибка чтения или записи снимка выводится в
+// stderr; без загруженного справочника запросы получают ответ "not found"
+class SerializationSettings final : public Query {
+public:
+  enum class Direction { SAVE, LOAD };
+
+  using Query::Query;
+  SerializationSettings(const std::string &file, Direction direction);
+  class Factory : public QueryFactory {
+  public:
+    using QueryFactory::QueryFactory;
+    Factory &SetFile(const std::string &file);
+    Factory &SetDirection(Direction direction);
+    [[nodiscard]] uniqueQuery Construct() const override;
+
+  private:
+    std::string file_;
+    Direction direction_{Direction::SAVE};
+  };
+  void Execute(QueryVisitor &visitor) const override;
+
+protected:
+  void Process(QueryVisitor &visitor) const;
+
+private:
+  std::string file_;
+  Direction direction_;
+};
+} // namespace serialization
+
 namespace router {
 class RoutingSettings final : public Query {
 public:
@@ -420,6 +504,9 @@ public:
     using QueryFactory::QueryFactory;
     Factory &SetBusWaitTime(double time);
     Factory &SetBusVelocity(double velocity);
+    Factory &SetRouterMode(::transport::router::RouterMode mode);
+    Factory &SetGraphModel(::transport::router::GraphModel model);
+    Factory &SetRouterFile(const std::string &file);
     [[nodiscard]] uniqueQuery Construct() const override;
 
   private:
@@ -464,14 +551,14 @@ private:
 class RouteQuery final : public ComputeQuery {
 public:
   using ComputeQuery::ComputeQuery;
-  RouteQuery(int id, const std::string &stop_from, const std::string &stop_to);
+  RouteQuery(int id, std::string_view stop_from, std::string_view stop_to);
 
   class Factory : public QueryFactory {
   public:
     using QueryFactory::QueryFactory;
     Factory &SetId(int requestId);
-    Factory &SetFromStop(const std::string &from);
-    Factory &SetToStop(const std::string &to);
+    Factory &SetFromStop(std::string_view from);
+    Factory &SetToStop(std::string_view to);
     [[nodiscard]] uniqueQuery Construct() const override;
 
   private:
@@ -479,6 +566,7 @@ public:
     std::string stop_from_{};
     std::string stop_to_{};
   };
+  void Prepare(QueryVisitor &visitor) const override;
 
 protected:
   void Process(QueryVisitor &visitor) const override;
@@ -528,6 +616,10 @@ public:
   void appendResponse(uniqueResponse) override;
 
 private:
+  // Выполняет подряд идущие ComputeQuery параллельно пачками; ответы каждой
+  // пачки передаются в Outputter в порядке запросов
+  void executeParallel_(const std::vector<const ComputeQuery *> &queries);
+
   // RequestHandler использует агрегацию объектов "Транспортный Справочник" и
   // "Визуализатор Карты" через владение уникальным указателем
   std::unique_ptr<Inputter> inputter_;
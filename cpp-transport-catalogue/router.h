@@ -6,112 +6,360 @@
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <tbb/blocked_range2d.h>
+#include <tbb/parallel_for.h>
+
 namespace graph {
 
+// Общий интерфейс маршрутизаторов: поиск кратчайшего пути между вершинами графа
+template <typename Weight>
+class RouterBase {
+public:
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    virtual ~RouterBase() = default;
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+
+    // Учитывает рёбра [first_edge, last_edge), которые добавлены в граф (вместе
+    // с новыми вершинами) или стали легче. Возвращает false, если маршрутизатор
+    // так обновить нельзя и его нужно построить заново
+    virtual bool Update(EdgeId /*first_edge*/, EdgeId /*last_edge*/) {
+        return false;
+    }
+};
+
+// Способ хранения таблицы маршрутов: типы весов и идентификаторов рёбер в матрицах
 template <typename Weight>
-class Router {
+struct ExactRouteStorage {
+    using StoredWeight = Weight;
+    using StoredEdgeId = EdgeId;
+};
+
+// Компактное хранение: 4 байта на вес и 4 байта на ребро вместо 8 + 8.
+// Вес найденного маршрута пересчитывается по его рёбрам в исходном типе Weight
+template <typename Weight>
+struct CompactRouteStorage {
+    using StoredWeight = float;
+    using StoredEdgeId = std::uint32_t;
+};
+
+// Маршрутизатор с предварительным расчётом маршрутов между всеми парами вершин.
+// Таблица маршрутов хранится плотно: матрица весов и матрица последних рёбер
+// маршрутов, их типы задаёт Storage. Расчёт - блочный алгоритм Флойда-Уоршелла,
+// независимые блоки каждой фазы обрабатываются параллельно.
+// Таблицы могут принадлежать маршрутизатору или лежать во внешней памяти,
+// например в отображённом файле; при обновлении внешние таблицы копируются.
+template <typename Weight, typename Storage = ExactRouteStorage<Weight>>
+class Router final : public RouterBase<Weight> {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
+    using typename RouterBase<Weight>::RouteInfo;
+    using StoredWeight = typename Storage::StoredWeight;
+    using StoredEdgeId = typename Storage::StoredEdgeId;
+
     explicit Router(const Graph& graph);
+    // Маршрутизатор над готовыми таблицами размером V*V, посчитанными для этого
+    // же графа. tables_owner продлевает жизнь памяти таблиц. Ребро, которого нет
+    // в графе, - std::invalid_argument
+    Router(const Graph& graph, const StoredWeight* weights, const StoredEdgeId* prev_edges,
+           std::shared_ptr<const void> tables_owner);
 
-    struct RouteInfo {
-        Weight weight;
-        std::vector<EdgeId> edges;
-    };
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    bool Update(EdgeId first_edge, EdgeId last_edge) override;
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    size_t GetVertexCount() const {
+        return vertex_count_;
+    }
+    const StoredWeight* GetWeights() const {
+        return weights_view_;
+    }
+    const StoredEdgeId* GetPrevEdges() const {
+        return prev_edges_view_;
+    }
 
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    static constexpr size_t BLOCK_SIZE = 64;
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr StoredWeight NO_ROUTE = std::numeric_limits<StoredWeight>::has_infinity
+                                                 ? std::numeric_limits<StoredWeight>::infinity()
+                                                 : std::numeric_limits<StoredWeight>::max();
+    static constexpr StoredEdgeId NO_EDGE = std::numeric_limits<StoredEdgeId>::max();
+
+    static bool IsReachable(StoredWeight weight) {
+        return weight < NO_ROUTE;
+    }
+
+    size_t GetIndex(VertexId from, VertexId to) const {
+        return from * vertex_count_ + to;
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            weights_[GetIndex(vertex, vertex)] = StoredWeight{};
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const size_t index = GetIndex(vertex, edge.to);
+                if (const auto weight = static_cast<StoredWeight>(edge.weight); weight < weights_[index]) {
+                    weights_[index] = weight;
+                    prev_edges_[index] = static_cast<StoredEdgeId>(edge_id);
+                }
+            }
+        }
+    }
+
+    // Релаксирует маршруты из вершин блока block_from в вершины блока block_to
+    // через вершины блока block_through
+    void RelaxBlock(size_t block_from, size_t block_to, size_t block_through) {
+        const auto block_end = [this](size_t block) {
+            return std::min((block + 1) * BLOCK_SIZE, vertex_count_);
+        };
+        const VertexId from_end = block_end(block_from);
+        const VertexId to_begin = block_to * BLOCK_SIZE;
+        const VertexId to_end = block_end(block_to);
+        const VertexId through_end = block_end(block_through);
+        for (VertexId vertex_through = block_through * BLOCK_SIZE; vertex_through < through_end; ++vertex_through) {
+            const StoredWeight* const weights_through = &weights_[GetIndex(vertex_through, 0)];
+            const StoredEdgeId* const prev_edges_through = &prev_edges_[GetIndex(vertex_through, 0)];
+            for (VertexId vertex_from = block_from * BLOCK_SIZE; vertex_from < from_end; ++vertex_from) {
+                StoredWeight* const weights_relaxing = &weights_[GetIndex(vertex_from, 0)];
+                StoredEdgeId* const prev_edges_relaxing = &prev_edges_[GetIndex(vertex_from, 0)];
+                const StoredWeight weight_from = weights_relaxing[vertex_through];
+                if (!IsReachable(weight_from)) {
+                    continue;
+                }
+                const StoredEdgeId prev_edge_from = prev_edges_relaxing[vertex_through];
+                for (VertexId vertex_to = to_begin; vertex_to < to_end; ++vertex_to) {
+                    // для весов с бесконечностью недостижимость проверять не нужно: inf + x = inf
+                    if constexpr (!std::numeric_limits<StoredWeight>::has_infinity) {
+                        if (!IsReachable(weights_through[vertex_to])) {
+                            continue;
+                        }
+                    }
+                    if (const StoredWeight candidate_weight = weight_from + weights_through[vertex_to];
+                        candidate_weight < weights_relaxing[vertex_to]) {
+                        weights_relaxing[vertex_to] = candidate_weight;
+                        prev_edges_relaxing[vertex_to] = prev_edges_through[vertex_to] != NO_EDGE
+                                                             ? prev_edges_through[vertex_to]
+                                                             : prev_edge_from;
+                    }
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    void RelaxRoutesInternalData() {
+        const size_t block_count = (vertex_count_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        for (size_t block_through = 0; block_through < block_count; ++block_through) {
+            // фаза 1: диагональный блок зависит только от себя
+            RelaxBlock(block_through, block_through, block_through);
+            // фаза 2: строка и столбец блока зависят от себя и диагонального блока
+            tbb::parallel_for(size_t{0}, block_count, [this, block_through](size_t block) {
+                if (block != block_through) {
+                    RelaxBlock(block_through, block, block_through);
+                    RelaxBlock(block, block_through, block_through);
+                }
+            });
+            // фаза 3: остальные блоки зависят от строки и столбца фазы 2
+            tbb::parallel_for(tbb::blocked_range2d<size_t>(0, block_count, 0, block_count),
+                              [this, block_through](const tbb::blocked_range2d<size_t>& range) {
+                                  for (size_t block_from = range.rows().begin(); block_from < range.rows().end();
+                                       ++block_from) {
+                                      for (size_t block_to = range.cols().begin(); block_to < range.cols().end();
+                                           ++block_to) {
+                                          if (block_from != block_through && block_to != block_through) {
+                                              RelaxBlock(block_from, block_to, block_through);
+                                          }
+                                      }
+                                  }
+                              });
+        }
+    }
+
+    // Расширяет таблицу маршрутов до vertex_count вершин, новые вершины недостижимы
+    void Resize(size_t vertex_count) {
+        std::vector<StoredWeight> weights(vertex_count * vertex_count, NO_ROUTE);
+        std::vector<StoredEdgeId> prev_edges(vertex_count * vertex_count, NO_EDGE);
+        for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+            std::copy_n(&weights_[GetIndex(vertex_from, 0)], vertex_count_, &weights[vertex_from * vertex_count]);
+            std::copy_n(&prev_edges_[GetIndex(vertex_from, 0)], vertex_count_,
+                        &prev_edges[vertex_from * vertex_count]);
+        }
+        for (VertexId vertex = vertex_count_; vertex < vertex_count; ++vertex) {
+            weights[vertex * vertex_count + vertex] = StoredWeight{};
+        }
+        vertex_count_ = vertex_count;
+        weights_ = std::move(weights);
+        prev_edges_ = std::move(prev_edges);
+    }
+
+    // Переносит внешние таблицы в собственные, чтобы их можно было менять
+    void OwnTables() {
+        if (tables_owner_ == nullptr) {
+            return;
         }
+        weights_.assign(weights_view_, weights_view_ + vertex_count_ * vertex_count_);
+        prev_edges_.assign(prev_edges_view_, prev_edges_view_ + vertex_count_ * vertex_count_);
+        tables_owner_.reset();
+    }
+
+    void UpdateViews() {
+        weights_view_ = weights_.data();
+        prev_edges_view_ = prev_edges_.data();
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+    // Релаксирует все маршруты через ребро edge_id: маршрут from -> to улучшается
+    // до from -> edge.from -> edge.to -> to. Маршруты из edge.to ребро улучшить
+    // не может, поэтому строка edge.to только читается
+    void RelaxEdge(EdgeId edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        const auto edge_weight = static_cast<StoredWeight>(edge.weight);
+        const StoredWeight* const weights_through = &weights_[GetIndex(edge.to, 0)];
+        const StoredEdgeId* const prev_edges_through = &prev_edges_[GetIndex(edge.to, 0)];
+        tbb::parallel_for(VertexId{0}, vertex_count_, [&](VertexId vertex_from) {
+            StoredWeight* const weights_relaxing = &weights_[GetIndex(vertex_from, 0)];
+            StoredEdgeId* const prev_edges_relaxing = &prev_edges_[GetIndex(vertex_from, 0)];
+            if (!IsReachable(weights_relaxing[edge.from])) {
+                return;
+            }
+            const StoredWeight weight_from = weights_relaxing[edge.from] + edge_weight;
+            // ребро не улучшает маршрут до edge.to - не улучшит и маршруты через него
+            if (!(weight_from < weights_relaxing[edge.to])) {
+                return;
+            }
+            for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+                if constexpr (!std::numeric_limits<StoredWeight>::has_infinity) {
+                    if (!IsReachable(weights_through[vertex_to])) {
+                        continue;
                     }
                 }
+                if (const StoredWeight candidate_weight = weight_from + weights_through[vertex_to];
+                    candidate_weight < weights_relaxing[vertex_to]) {
+                    weights_relaxing[vertex_to] = candidate_weight;
+                    prev_edges_relaxing[vertex_to] = prev_edges_through[vertex_to] != NO_EDGE
+                                                         ? prev_edges_through[vertex_to]
+                                                         : static_cast<StoredEdgeId>(edge_id);
+                }
             }
-        }
+        });
     }
 
-    static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    size_t vertex_count_;
+    // веса маршрутов, NO_ROUTE - маршрута нет
+    std::vector<StoredWeight> weights_;
+    // последнее ребро маршрута, NO_EDGE - маршрут пустой
+    std::vector<StoredEdgeId> prev_edges_;
+    // таблицы, по которым ищутся маршруты: собственные или внешние
+    const StoredWeight* weights_view_ = nullptr;
+    const StoredEdgeId* prev_edges_view_ = nullptr;
+    std::shared_ptr<const void> tables_owner_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename Storage>
+Router<Weight, Storage>::Router(const Graph& graph)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , vertex_count_(graph.GetVertexCount())
 {
+    // NO_EDGE не должен совпадать с идентификатором реального ребра
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the route table edge id type");
+    }
+    weights_.assign(vertex_count_ * vertex_count_, NO_ROUTE);
+    prev_edges_.assign(vertex_count_ * vertex_count_, NO_EDGE);
     InitializeRoutesInternalData(graph);
+    RelaxRoutesInternalData();
+    UpdateViews();
+}
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+template <typename Weight, typename Storage>
+Router<Weight, Storage>::Router(const Graph& graph, const StoredWeight* weights, const StoredEdgeId* prev_edges,
+                                std::shared_ptr<const void> tables_owner)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , weights_view_(weights)
+    , prev_edges_view_(prev_edges)
+    , tables_owner_(std::move(tables_owner))
+{
+    const size_t edge_count = graph.GetEdgeCount();
+    for (size_t index = 0; index < vertex_count_ * vertex_count_; ++index) {
+        if (prev_edges[index] != NO_EDGE && prev_edges[index] >= edge_count) {
+            throw std::invalid_argument("Route table refers to a missing edge");
+        }
     }
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+template <typename Weight, typename Storage>
+bool Router<Weight, Storage>::Update(EdgeId first_edge, EdgeId last_edge) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    // обновление стоит O(V^2) на ребро: при V и более рёбрах дешевле пересчитать таблицу
+    if (last_edge - first_edge >= vertex_count || graph_.GetEdgeCount() >= NO_EDGE) {
+        return false;
+    }
+    OwnTables();
+    if (vertex_count_ < vertex_count) {
+        Resize(vertex_count);
+    }
+    for (EdgeId edge_id = first_edge; edge_id < last_edge; ++edge_id) {
+        RelaxEdge(edge_id);
+    }
+    UpdateViews();
+    return true;
+}
+
+template <typename Weight, typename Storage>
+std::optional<typename Router<Weight, Storage>::RouteInfo> Router<Weight, Storage>::BuildRoute(VertexId from,
+                                                                                               VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const StoredWeight stored_weight = weights_view_[GetIndex(from, to)];
+    if (!IsReachable(stored_weight)) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (StoredEdgeId edge_id = prev_edges_view_[GetIndex(from, to)];
+         edge_id != NO_EDGE;
+         edge_id = prev_edges_view_[GetIndex(from, graph_.GetEdge(edge_id).from)])
     {
-        edges.push_back(*edge_id);
+        // кратчайший маршрут проходит вершину не больше одного раза: длиннее
+        // может быть только цикл в испорченной таблице
+        if (edges.size() == vertex_count_) {
+            throw std::logic_error("Route table contains a cycle");
+        }
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
-    return RouteInfo{weight, std::move(edges)};
+    if constexpr (std::is_same_v<StoredWeight, Weight>) {
+        return RouteInfo{stored_weight, std::move(edges)};
+    } else {
+        // хранимый вес округлён, точный вес маршрута - сумма весов его рёбер
+        Weight weight = ZERO_WEIGHT;
+        for (const EdgeId edge_id : edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+        return RouteInfo{weight, std::move(edges)};
+    }
 }
 
 }  // namespace graph
\ No newline at end of file
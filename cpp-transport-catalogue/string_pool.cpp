@@ -0,0 +1,84 @@
+#include "string_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+using namespace std;
+
+namespace transport::detail {
+namespace {
+// размер блока символов; более длинные строки получают отдельный блок
+inline constexpr size_t POOL_BLOCK_SIZE = size_t{1} << 16;
+inline constexpr size_t POOL_FIRST_TABLE_SIZE = size_t{1} << 10;
+} // namespace
+
+StringPool &StringPool::instance() {
+  static StringPool pool;
+  return pool;
+}
+
+string_view StringPool::intern(string_view str) {
+  if (str.empty()) {
+    return {};
+  }
+  const size_t hash = std::hash<string_view>{}(str);
+  const lock_guard lock(mutex_);
+  if (2 * (count_ + 1) > slots_.size()) {
+    grow_();
+  }
+  const size_t mask = slots_.size() - 1;
+  for (size_t index = hash & mask;; index = (index + 1) & mask) {
+    Slot &slot = slots_[index];
+    if (slot.str.data() == nullptr) {
+      slot = {hash, store_(str)};
+      ++count_;
+      return slot.str;
+    }
+    if (slot.hash == hash && slot.str == str) {
+      return slot.str;
+    }
+  }
+}
+
+size_t StringPool::size() const {
+  const lock_guard lock(mutex_);
+  return count_;
+}
+
+void StringPool::grow_() {
+  vector<Slot> slots(max(POOL_FIRST_TABLE_SIZE, slots_.size() * 2),
+                     Slot{0, {}});
+  const size_t mask = slots.size() - 1;
+  for (const Slot &slot : slots_) {
+    if (slot.str.data() == nullptr) {
+      continue;
+    }
+    size_t index = slot.hash & mask;
+    while (slots[index].str.data() != nullptr) {
+      index = (index + 1) & mask;
+    }
+    slots[index] = slot;
+  }
+  slots_.swap(slots);
+}
+
+string_view StringPool::store_(string_view str) {
+  if (str.size() > free_size_) {
+    const size_t block_size = max(POOL_BLOCK_SIZE, str.size());
+    blocks_.push_back(make_unique<char[]>(block_size));
+    free_ = blocks_.back().get();
+    free_size_ = block_size;
+  }
+  char *chars = free_;
+  memcpy(chars, str.data(), str.size());
+  free_ += str.size();
+  free_size_ -= str.size();
+  return {chars, str.size()};
+}
+
+string_view Intern(string_view str) {
+  return StringPool::instance().intern(str);
+}
+
+} // namespace transport::detail
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace transport::detail {
+
+// Пул названий на всё время работы программы: каждая строка хранится один
+// раз, а возвращаемые string_view действительны до завершения программы.
+// Символы размещаются блоками, поэтому добавление строки не требует
+// отдельного выделения памяти. Индекс - таблица с открытой адресацией, в
+// ячейке хранится хэш строки, так что поиск обычно читает одну ячейку и
+// сравнивает символы только при совпадении хэша
+class StringPool {
+public:
+  StringPool(const StringPool &other) = delete;
+  StringPool &operator=(const StringPool &other) = delete;
+
+  static StringPool &instance();
+
+  // Возвращает строку пула, равную str, добавляя её при необходимости.
+  // Потокобезопасен
+  std::string_view intern(std::string_view str);
+
+  [[nodiscard]] size_t size() const;
+
+private:
+  StringPool() = default;
+
+  struct Slot {
+    size_t hash;
+    // пустая ячейка - nullptr в data()
+    std::string_view str;
+  };
+
+  std::string_view store_(std::string_view str);
+  void grow_();
+
+  mutable std::mutex mutex_;
+  // размер - степень двойки, заполнено не больше половины
+  std::vector<Slot> slots_{};
+  size_t count_{};
+  std::vector<std::unique_ptr<char[]>> blocks_{};
+  // свободное место в последнем блоке
+  char *free_{nullptr};
+  size_t free_size_{};
+};
+
+// Сокращение для StringPool::instance().intern(str)
+std::string_view Intern(std::string_view str);
+
+} // namespace transport::detail
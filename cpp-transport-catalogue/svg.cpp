@@ -110,7 +110,8 @@ void Object::Render(svg::RenderContext context) const {
 
   // Делегируем вывод тега своим подклассам
   RenderObject(context);
-  context.out << std::endl;
+  // без сброса буфера на каждом объекте: поток сбрасывается в конце документа
+  context.out << '\n';
 }
 
 // ---------- Circle ------------------
@@ -239,6 +240,24 @@ void Polyline::RenderObject(const RenderContext &context) const {
 }
 
 // ---------- Document------------------
+namespace {
+void RenderHeader(std::ostream &out, const ViewBox *view_box = nullptr) {
+  out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << endl;
+  out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\""sv;
+  out.unsetf(ios::fixed);
+  if (view_box != nullptr) {
+    out << " viewBox=\""sv << view_box->origin.x << ' ' << view_box->origin.y
+        << ' ' << view_box->width << ' ' << view_box->height << '"';
+  }
+  out << ">"sv << endl;
+}
+
+void RenderFooter(std::ostream &out) {
+  out << "</svg>"sv;
+  out.flush();
+}
+} // namespace
+
 void Document::AddPtr(std::unique_ptr<Object> &&obj) {
   if (obj == nullptr) {
     return;
@@ -248,14 +267,60 @@ void Document::AddPtr(std::unique_ptr<Object> &&obj) {
 
 void Document::Render(std::ostream &out) const {
   RenderContext ctx(out, 2, 2);
-  out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << endl;
-  out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << endl;
-  out.unsetf(ios::fixed);
+  RenderHeader(out);
   for (const auto &object : objects_) {
     object->Render(ctx);
   }
-  out << "</svg>"sv;
-  out.flush();
+  RenderFooter(out);
+}
+
+// ---------- StreamDocument------------------
+StreamDocument::StreamDocument(std::ostream &out) : context_(out, 2, 2) {
+  RenderHeader(out);
+}
+
+StreamDocument::StreamDocument(std::ostream &out, const ViewBox &view_box)
+    : context_(out, 2, 2) {
+  RenderHeader(out, &view_box);
+}
+
+void StreamDocument::AddPtr(std::unique_ptr<Object> &&obj) {
+  if (obj == nullptr) {
+    return;
+  }
+  obj->Render(context_);
+}
+
+void StreamDocument::Close() { RenderFooter(context_.out); }
+
+// ---------- StringStream------------------
+StringStream::StringStream() : std::ostream(&buffer_) {}
+
+std::string StringStream::Release() { return buffer_.Release(); }
+
+size_t StringStream::Buffer::Used() const {
+  // до первой записи области вывода нет, pptr() - nullptr
+  return text_.empty() ? 0 : static_cast<size_t>(pptr() - text_.data());
+}
+
+std::string StringStream::Buffer::Release() {
+  text_.resize(Used());
+  std::string text = std::move(text_);
+  text_.clear();
+  setp(nullptr, nullptr);
+  return text;
+}
+
+StringStream::Buffer::int_type StringStream::Buffer::overflow(int_type chr) {
+  const size_t used = Used();
+  text_.resize(std::max<size_t>(2 * text_.size(), 256));
+  setp(text_.data() + used, text_.data() + text_.size());
+  if (traits_type::eq_int_type(chr, traits_type::eof())) {
+    return traits_type::not_eof(chr);
+  }
+  *pptr() = traits_type::to_char_type(chr);
+  pbump(1);
+  return chr;
 }
 
 // ---------- Rgb------------------
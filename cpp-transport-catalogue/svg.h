@@ -284,4 +284,63 @@ private:
   std::deque<std::unique_ptr<Object>> objects_{};
 };
 
+// Видимая область рисунка (атрибут viewBox): левый верхний угол и размеры
+struct ViewBox {
+  Point origin;
+  double width = 0;
+  double height = 0;
+};
+
+/*
+ * Потоковый документ: объекты выводятся в поток сразу при добавлении и не
+ * хранятся, память не зависит от размера рисунка. Заголовок выводится при
+ * создании, закрывающий тег - методом Close, который нужно вызвать в конце
+ */
+class StreamDocument final : public ObjectContainer {
+public:
+  explicit StreamDocument(std::ostream &out);
+  // Документ, показывающий только часть рисунка
+  StreamDocument(std::ostream &out, const ViewBox &view_box);
+
+  // Выводит объект без размещения его копии в куче
+  template <typename Obj> void Add(const Obj &obj) { obj.Render(context_); }
+  void AddPtr(std::unique_ptr<Object> &&obj) override;
+
+  // Завершает документ
+  void Close();
+
+private:
+  RenderContext context_;
+};
+
+/*
+ * Поток вывода в строку. В отличие от std::ostringstream::str() готовый текст
+ * забирается без копирования
+ */
+class StringStream final : public std::ostream {
+public:
+  StringStream();
+
+  // Забирает выведенный текст, поток становится пустым
+  std::string Release();
+
+private:
+  // Буфер пишет прямо в строку, увеличивая её вдвое при заполнении
+  class Buffer final : public std::streambuf {
+  public:
+    std::string Release();
+
+  protected:
+    int_type overflow(int_type chr) override;
+
+  private:
+    std::string text_;
+
+    // Длина выведенного текста
+    [[nodiscard]] size_t Used() const;
+  };
+
+  Buffer buffer_;
+};
+
 } // namespace svg
@@ -0,0 +1,165 @@
+// Проверка поиска структурных символов JSON: реализации SSE2/AVX2 должны
+// находить тот же символ, что и скалярная, на случайных буферах, где
+// искомые символы стоят на границах блоков 16 и 32 байта. Разбор потока
+// проверяется на строках и пробелах, пересекающих границы порций чтения
+
+#include "json.h"
+#include "json_scan.h"
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using json::detail::ScanImplementation;
+
+namespace {
+inline constexpr size_t BUFFER_SIZE = 160;
+inline constexpr int BUFFER_COUNT = 2000;
+// размер порции чтения потока в json.cpp
+inline constexpr size_t STREAM_CHUNK_SIZE = size_t{1} << 16;
+
+const char STRING_SPECIALS[] = {'"', '\\', '\n', '\r'};
+const char SPACES[] = {' ', '\t', '\n', '\r', '\v', '\f'};
+// позиции около границ блоков SSE2 и AVX2
+const size_t EDGES[] = {0, 1, 15, 16, 17, 31, 32, 33, 47, 48, 63, 64, 65, 95, 96};
+
+using Scan = const char *(*)(const char *, const char *);
+
+// Сравнивает scan со скалярным reference на всех участках buffer с началом
+// 0..3 (разное выравнивание) и любым концом
+bool Compare(const string &buffer, Scan scan, Scan reference,
+             const char *name) {
+  for (size_t first = 0; first < 4; ++first) {
+    for (size_t last = first; last <= buffer.size(); ++last) {
+      const char *begin = buffer.data() + first;
+      const char *end = buffer.data() + last;
+      if (scan(begin, end) != reference(begin, end)) {
+        cerr << name << ": mismatch on [" << first << ", " << last << ")"
+             << endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Случайные байты, включая старшие и соседние с управляющими, с искомым
+// символом на границе блока и в случайном месте
+string MakeStringBuffer(mt19937 &rng) {
+  string buffer(BUFFER_SIZE, '\0');
+  for (char &chr : buffer) {
+    // редкие искомые символы, чтобы участки без них были длинными
+    chr = static_cast<char>(rng() % 256);
+    for (const char special : STRING_SPECIALS) {
+      if (chr == special) {
+        chr = 'a';
+      }
+    }
+  }
+  buffer[EDGES[rng() % size(EDGES)]] = STRING_SPECIALS[rng() % 4];
+  if (rng() % 2 == 0) {
+    buffer[rng() % BUFFER_SIZE] = STRING_SPECIALS[rng() % 4];
+  }
+  return buffer;
+}
+
+// Пробелы всех видов до первого непробельного символа на границе блока.
+// Непробельный символ - любой байт, в том числе соседний с '\t'..'\r' и ' '
+string MakeSpaceBuffer(mt19937 &rng) {
+  string buffer(BUFFER_SIZE, ' ');
+  for (char &chr : buffer) {
+    chr = SPACES[rng() % size(SPACES)];
+  }
+  const char others[] = {'\x08', '\x0E', '\x1F', '!', '\0', '\x89', '\xA0',
+                         '{'};
+  char other = others[rng() % size(others)];
+  if (rng() % 2 == 0) {
+    other = static_cast<char>(rng() % 256);
+  }
+  buffer[EDGES[rng() % size(EDGES)]] = other;
+  return buffer;
+}
+
+bool TestImplementations() {
+  const vector<ScanImplementation> implementations =
+      json::detail::GetScanImplementations();
+  const ScanImplementation &scalar = implementations.front();
+  mt19937 rng(7);
+  for (int count = 0; count < BUFFER_COUNT; ++count) {
+    const string strings = MakeStringBuffer(rng);
+    const string spaces = MakeSpaceBuffer(rng);
+    for (const ScanImplementation &implementation : implementations) {
+      if (!Compare(strings, implementation.find_string_special,
+                   scalar.find_string_special, implementation.name) ||
+          !Compare(spaces, implementation.skip_spaces, scalar.skip_spaces,
+                   implementation.name)) {
+        return false;
+      }
+    }
+    // общий вход с проверкой первого блока на месте
+    if (!Compare(strings, json::detail::FindStringSpecial,
+                 scalar.find_string_special, "FindStringSpecial") ||
+        !Compare(spaces, json::detail::SkipSpaces, scalar.skip_spaces,
+                 "SkipSpaces")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Массив строк с экранированием и пробелами между элементами; строки и
+// пробелы пересекают границы порций чтения потока
+bool TestStreamChunks() {
+  mt19937 rng(11);
+  json::Array expected;
+  string input = "[";
+  while (input.size() < 4 * STREAM_CHUNK_SIZE) {
+    string value;
+    input += '"';
+    for (size_t length = rng() % 300; length > 0; --length) {
+      const char chr = static_cast<char>('a' + rng() % 26);
+      switch (rng() % 20) {
+      case 0:
+        value += '"';
+        input += "\\\"";
+        break;
+      case 1:
+        value += '\n';
+        input += "\\n";
+        break;
+      case 2:
+        value += '\\';
+        input += "\\\\";
+        break;
+      default:
+        value += chr;
+        input += chr;
+      }
+    }
+    input += '"';
+    input.append(rng() % 70, SPACES[rng() % size(SPACES)]);
+    input += ',';
+    input.append(rng() % 70, ' ');
+    expected.emplace_back(move(value));
+  }
+  input += "\"\"]";
+  expected.emplace_back(string());
+
+  const json::Document from_buffer = json::Load(string_view(input));
+  istringstream stream(input);
+  const json::Document from_stream = json::Load(stream);
+  if (from_buffer.GetRoot() != json::Node(expected) ||
+      from_stream.GetRoot() != json::Node(expected)) {
+    cerr << "stream chunks: parsed strings differ" << endl;
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+int main() {
+  const bool passed = TestImplementations() && TestStreamChunks();
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+// Проверка фрагментов карты: обрезка отрезков по плитке, выдача объектов
+// сеткой GridIndex и совпадение плитки нулевого уровня с полной картой
+
+#include "map_renderer.h"
+#include "map_tiles.h"
+#include "transport_catalogue.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace transport;
+using namespace transport::renderer;
+
+namespace {
+inline constexpr TileBox BOX{0., 0., 100., 100.};
+
+bool Near(svg::Point lhs, svg::Point rhs) {
+  return abs(lhs.x - rhs.x) < 1e-9 && abs(lhs.y - rhs.y) < 1e-9;
+}
+
+// Ожидаемый результат обрезки [from, to]; nullopt - отрезок снаружи
+bool CheckClip(svg::Point from, svg::Point to,
+               const optional<ClippedSegment> &expected) {
+  const auto clipped = ClipSegment(BOX, from, to);
+  const bool passed =
+      clipped.has_value() == expected.has_value() &&
+      (!clipped.has_value() ||
+       (Near(clipped->from, expected->from) &&
+        Near(clipped->to, expected->to) &&
+        clipped->from_clipped == expected->from_clipped &&
+        clipped->to_clipped == expected->to_clipped));
+  if (!passed) {
+    cerr << "clip (" << from.x << ", " << from.y << ") - (" << to.x << ", "
+         << to.y << ") is wrong" << endl;
+  }
+  return passed;
+}
+
+bool TestClipSegment() {
+  bool passed = true;
+  // целиком внутри, в том числе по границе
+  passed =
+      CheckClip({10, 10}, {90, 50}, {{{10, 10}, {90, 50}, false, false}}) &&
+      passed;
+  passed = CheckClip({0, 0}, {100, 0}, {{{0, 0}, {100, 0}, false, false}}) &&
+           passed;
+  // целиком снаружи: сбоку, параллельно границе, мимо угла
+  passed = CheckClip({110, 10}, {150, 90}, nullopt) && passed;
+  passed = CheckClip({10, -5}, {90, -5}, nullopt) && passed;
+  passed = CheckClip({90, -20}, {120, 10}, nullopt) && passed;
+  // пересекает: выходит наружу, проходит насквозь, входит по диагонали
+  passed =
+      CheckClip({50, 50}, {150, 50}, {{{50, 50}, {100, 50}, false, true}}) &&
+      passed;
+  passed =
+      CheckClip({-50, 50}, {150, 50}, {{{0, 50}, {100, 50}, true, true}}) &&
+      passed;
+  passed =
+      CheckClip({-10, -10}, {110, 110}, {{{0, 0}, {100, 100}, true, true}}) &&
+      passed;
+  passed =
+      CheckClip({50, 120}, {50, 50}, {{{50, 100}, {50, 50}, true, false}}) &&
+      passed;
+  return passed;
+}
+
+// Сетка должна выдавать все объекты, пересекающие запрос, по возрастанию и
+// без повторов
+bool TestGridIndex() {
+  constexpr double width = 1000.;
+  constexpr double height = 600.;
+  mt19937 rng(3);
+  uniform_real_distribution<double> coordinate(-50., 1050.);
+  const auto random_box = [&rng, &coordinate](double max_size) {
+    const double x = coordinate(rng);
+    const double y = coordinate(rng) * height / width;
+    uniform_real_distribution<double> size(0., max_size);
+    return TileBox{x, y, x + size(rng), y + size(rng)};
+  };
+  vector<TileBox> boxes;
+  for (int index = 0; index < 2000; ++index) {
+    // в основном мелкие объекты и немного длинных отрезков
+    boxes.push_back(random_box(index % 50 == 0 ? 800. : 20.));
+  }
+  GridIndex grid;
+  grid.Build(boxes, width, height);
+
+  vector<uint32_t> result;
+  for (int query = 0; query < 500; ++query) {
+    const TileBox box = random_box(query % 10 == 0 ? 1000. : 100.);
+    result.clear();
+    grid.Query(box, result);
+    if (!is_sorted(result.begin(), result.end()) ||
+        adjacent_find(result.begin(), result.end()) != result.end()) {
+      cerr << "grid: result is not sorted or has duplicates" << endl;
+      return false;
+    }
+    for (uint32_t index = 0; index < boxes.size(); ++index) {
+      if (boxes[index].Intersects(box) &&
+          !binary_search(result.begin(), result.end(), index)) {
+        cerr << "grid: object " << index << " is missing" << endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Плитка 0/0/0 - вся карта; отличается только областью просмотра
+bool TestZeroZoomTile() {
+  deque<string> names;
+  auto catalogue = TransportCatalogue::Make();
+  mt19937 rng(5);
+  vector<string_view> stop_names;
+  for (int index = 0; index < 30; ++index) {
+    StopData stop(names.emplace_back("Stop " + to_string(index)));
+    stop.coordinates = {55.5 + 0.001 * static_cast<double>(rng() % 500),
+                        37.5 + 0.001 * static_cast<double>(rng() % 500)};
+    catalogue->addStop(stop);
+    stop_names.push_back(stop.name);
+  }
+  for (int index = 0; index < 6; ++index) {
+    BusData bus(names.emplace_back("Bus " + to_string(index)));
+    for (int count = 0; count < 6; ++count) {
+      bus.stops.push_back(stop_names[rng() % stop_names.size()]);
+    }
+    bus.is_roundtrip = index % 2 == 0;
+    if (bus.is_roundtrip) {
+      bus.stops.push_back(bus.stops.front());
+    }
+    catalogue->addBus(bus);
+  }
+
+  RenderSettings settings;
+  settings.setSize(1200, 500, 50);
+  settings.setLineWidth(14);
+  settings.setStopExterior(5, 20, {7, -3});
+  settings.setBusExterior(20, {7, 15});
+  settings.setUnderlayerExterior(3, svg::Rgba(255, 255, 255, 0.85));
+  settings.setColorPalette({"green", svg::Rgb(255, 160, 0), "red"});
+  auto renderer = MapRenderer::Make();
+  renderer->SetSettings(settings);
+
+  const auto map = renderer->renderMap(*catalogue);
+  const auto tile = renderer->renderTile(*catalogue, TileAddress{0, 0, 0});
+  if (map == nullptr || tile == nullptr) {
+    cerr << "zero zoom tile: nothing rendered" << endl;
+    return false;
+  }
+  string tile_text = *tile;
+  if (const size_t begin = tile_text.find(" viewBox=\"");
+      begin != string::npos) {
+    tile_text.erase(begin, tile_text.find('"', begin + 10) + 1 - begin);
+  }
+  if (tile_text != *map) {
+    cerr << "zero zoom tile differs from the full map" << endl;
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+int main() {
+  bool passed = TestClipSegment();
+  passed = TestGridIndex() && passed;
+  passed = TestZeroZoomTile() && passed;
+  return passed ? 0 : 1;
+}
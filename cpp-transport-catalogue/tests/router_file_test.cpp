@@ -0,0 +1,159 @@
+// Проверка файла таблиц маршрутизатора: испорченный файл не загружается, а
+// таблицы пересчитываются; таблица с несуществующим ребром отвергается, а
+// цикл в таблице не зацикливает восстановление маршрута
+
+#include "router.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace transport;
+
+namespace {
+inline constexpr size_t STOP_COUNT = 30;
+inline constexpr size_t BUS_COUNT = 8;
+// начало матрицы весов: заголовок, выровненный на 64 байта
+inline constexpr size_t WEIGHTS_OFFSET = 64;
+
+// хранилище названий: справочник хранит string_view
+deque<string> names;
+vector<string_view> stop_names;
+
+unique_ptr<TransportCatalogue> MakeCatalogue() {
+  mt19937 rng(9);
+  auto catalogue = TransportCatalogue::Make();
+  for (size_t index = 0; index < STOP_COUNT; ++index) {
+    StopData stop(names.emplace_back("Stop " + to_string(index)));
+    stop.coordinates = {55.5 + 0.001 * static_cast<double>(rng() % 500),
+                        37.5 + 0.001 * static_cast<double>(rng() % 500)};
+    catalogue->addStop(stop);
+    stop_names.push_back(stop.name);
+  }
+  for (size_t index = 0; index < BUS_COUNT; ++index) {
+    BusData bus(names.emplace_back("Bus " + to_string(index)));
+    for (size_t count = 0; count < 6; ++count) {
+      bus.stops.push_back(stop_names[rng() % STOP_COUNT]);
+    }
+    bus.is_roundtrip = index % 2 == 0;
+    if (bus.is_roundtrip) {
+      bus.stops.push_back(bus.stops.front());
+    }
+    catalogue->addBus(bus);
+  }
+  return catalogue;
+}
+
+unique_ptr<TransportRouter> MakeRouter(const TransportCatalogue &catalogue,
+                                       router::RouterMode mode,
+                                       const string &file_name) {
+  router::RoutingSettings settings;
+  settings.bus_wait = 3;
+  settings.bus_velocity = 35;
+  settings.mode = mode;
+  settings.router_file = file_name;
+  auto router = TransportRouter::Make();
+  router->SetSettings(settings);
+  router->UploadData(catalogue.getStopCount(),
+                     catalogue.getRoutesInfo().value());
+  return router;
+}
+
+// Время маршрута для каждой пары остановок, nullopt - маршрута нет
+vector<optional<double>> FindAll(const TransportRouter &router) {
+  vector<optional<double>> times;
+  for (const string_view from : stop_names) {
+    for (const string_view to : stop_names) {
+      const auto route = router.FindRoute(from, to);
+      times.push_back(route.has_value() ? optional(route->total_time)
+                                        : nullopt);
+    }
+  }
+  return times;
+}
+
+bool Equal(const vector<optional<double>> &lhs,
+           const vector<optional<double>> &rhs) {
+  for (size_t index = 0; index < rhs.size(); ++index) {
+    if (lhs[index].has_value() != rhs[index].has_value() ||
+        (lhs[index].has_value() &&
+         abs(*lhs[index] - *rhs[index]) > 1e-9 * max(1., *rhs[index]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Веса маршрутов из первой вершины обнуляются: загруженные без проверки
+// таблицы дали бы нулевое время этих маршрутов
+void CorruptWeights(const string &file_name) {
+  fstream file(file_name, ios::in | ios::out | ios::binary);
+  const string zeros(STOP_COUNT * sizeof(double), '\0');
+  file.seekp(WEIGHTS_OFFSET);
+  file.write(zeros.data(), static_cast<streamsize>(zeros.size()));
+}
+
+bool TestCorruptedFile(const string &file_name) {
+  const auto catalogue = MakeCatalogue();
+  const auto reference = FindAll(
+      *MakeRouter(*catalogue, router::RouterMode::ON_DEMAND, string()));
+  // первый запуск записывает файл, второй загружает испорченный
+  MakeRouter(*catalogue, router::RouterMode::PRECOMPUTED, file_name);
+  CorruptWeights(file_name);
+  const auto times = FindAll(
+      *MakeRouter(*catalogue, router::RouterMode::PRECOMPUTED, file_name));
+  if (!Equal(times, reference)) {
+    cerr << "corrupted router file: tables have been loaded" << endl;
+    return false;
+  }
+  return true;
+}
+
+// Граф 0 -> 1 <-> 2 и таблицы, где маршрут 0 -> 2 ходит по кругу 1 <-> 2
+bool TestBrokenTables() {
+  graph::DirectedWeightedGraph<double> graph(3);
+  graph.AddEdge({0, 1, 1.});
+  graph.AddEdge({1, 2, 1.});
+  graph.AddEdge({2, 1, 1.});
+  using Router = graph::Router<double>;
+  constexpr graph::EdgeId NO_EDGE = numeric_limits<graph::EdgeId>::max();
+  const vector<double> weights(9, 1.);
+  vector<graph::EdgeId> prev_edges(9, NO_EDGE);
+  prev_edges[1] = 2;
+  prev_edges[2] = 1;
+  bool passed = true;
+  try {
+    Router(graph, weights.data(), prev_edges.data(), nullptr).BuildRoute(0, 2);
+    cerr << "broken tables: a cycle has not been detected" << endl;
+    passed = false;
+  } catch (const logic_error &) {
+  }
+  prev_edges[2] = 3;
+  try {
+    Router router(graph, weights.data(), prev_edges.data(), nullptr);
+    cerr << "broken tables: a missing edge has not been detected" << endl;
+    passed = false;
+  } catch (const invalid_argument &) {
+  }
+  return passed;
+}
+} // namespace
+
+int main() {
+  const string file_name =
+      (filesystem::temp_directory_path() / "transport_catalogue_router_test")
+          .string();
+  bool passed = TestCorruptedFile(file_name);
+  passed = TestBrokenTables() && passed;
+  filesystem::remove(file_name);
+  return passed ? 0 : 1;
+}
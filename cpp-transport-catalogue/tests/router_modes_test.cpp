@@ -0,0 +1,157 @@
+// Согласованность режимов маршрутизатора: таблица всех пар (блочный
+// Флойд-Уоршелл), её компактный вариант и иерархия сжатий в обеих моделях
+// графа должны находить маршруты того же времени, что и алгоритм Дейкстры
+// (ON_DEMAND) на графе STOP_TO_STOP, для каждой пары остановок случайного
+// справочника. Время маршрута от модели графа не зависит, поэтому эталон
+// строится один раз.
+//
+// Остановок больше двух блоков Флойда-Уоршелла (по 64 вершины); часть
+// остановок не обслуживается ни одним автобусом, так что проверяется и
+// отсутствие маршрута
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace transport;
+
+namespace {
+inline constexpr size_t STOP_COUNT = 136;
+// остановки с этим номером и больше не входят в маршруты
+inline constexpr size_t SERVED_STOP_COUNT = 128;
+inline constexpr size_t BUS_COUNT = 28;
+
+struct Dataset {
+  // хранилище названий: справочник хранит string_view
+  deque<string> names;
+  vector<StopData> stops;
+  vector<BusData> buses;
+};
+
+Dataset MakeDataset(uint32_t seed) {
+  mt19937 rng(seed);
+  Dataset data;
+  for (size_t index = 0; index < STOP_COUNT; ++index) {
+    StopData stop(data.names.emplace_back("Stop " + to_string(index)));
+    stop.coordinates = {55.5 + 0.001 * static_cast<double>(rng() % 500),
+                        37.5 + 0.001 * static_cast<double>(rng() % 500)};
+    data.stops.push_back(stop);
+  }
+  for (size_t index = 0; index < BUS_COUNT; ++index) {
+    BusData bus(data.names.emplace_back("Bus " + to_string(index)));
+    const size_t length = 4 + rng() % 12;
+    for (size_t count = 0; count < length; ++count) {
+      bus.stops.push_back(data.stops[rng() % SERVED_STOP_COUNT].name);
+    }
+    bus.is_roundtrip = rng() % 2 == 0;
+    if (bus.is_roundtrip) {
+      bus.stops.push_back(bus.stops.front());
+    }
+    data.buses.push_back(bus);
+  }
+  // расстояния между соседними остановками; обратное направление часто
+  // не задано и берётся из прямого
+  for (const BusData &bus : data.buses) {
+    for (size_t index = 0; index + 1 < bus.stops.size(); ++index) {
+      for (StopData &stop : data.stops) {
+        if (stop.name == bus.stops[index]) {
+          stop.road_distances[bus.stops[index + 1]] =
+              static_cast<double>(200 + rng() % 5000);
+        }
+      }
+    }
+  }
+  return data;
+}
+
+unique_ptr<TransportRouter> MakeRouter(const TransportCatalogue &catalogue,
+                                       router::RouterMode mode,
+                                       router::GraphModel model) {
+  router::RoutingSettings settings;
+  settings.bus_wait = 3;
+  settings.bus_velocity = 35;
+  settings.mode = mode;
+  settings.graph_model = model;
+  auto router = TransportRouter::Make();
+  router->SetSettings(settings);
+  router->UploadData(catalogue.getStopCount(),
+                     catalogue.getRoutesInfo().value());
+  return router;
+}
+
+// Время маршрута для каждой пары остановок, nullopt - маршрута нет
+vector<optional<double>> FindAll(const Dataset &data,
+                                 const TransportRouter &router) {
+  vector<optional<double>> times;
+  times.reserve(data.stops.size() * data.stops.size());
+  for (const StopData &from : data.stops) {
+    for (const StopData &to : data.stops) {
+      const auto route = router.FindRoute(from.name, to.name);
+      times.push_back(route.has_value() ? optional(route->total_time)
+                                        : nullopt);
+    }
+  }
+  return times;
+}
+
+// Число пар остановок, для которых ответы расходятся. Допуск - под веса
+// float режима PRECOMPUTED_COMPACT
+size_t CountMismatches(const vector<optional<double>> &times,
+                       const vector<optional<double>> &reference) {
+  size_t mismatches = 0;
+  for (size_t index = 0; index < reference.size(); ++index) {
+    const auto &lhs = times[index];
+    const auto &rhs = reference[index];
+    if (lhs.has_value() != rhs.has_value() ||
+        (lhs.has_value() &&
+         abs(*lhs - *rhs) > 1e-5 * max(1., *rhs))) {
+      ++mismatches;
+    }
+  }
+  return mismatches;
+}
+} // namespace
+
+int main() {
+  const router::RouterMode modes[] = {
+      router::RouterMode::PRECOMPUTED, router::RouterMode::PRECOMPUTED_COMPACT,
+      router::RouterMode::ON_DEMAND, router::RouterMode::CONTRACTION_HIERARCHY};
+  const router::GraphModel models[] = {router::GraphModel::STOP_TO_STOP,
+                                       router::GraphModel::RIDE_VERTICES};
+  const Dataset data = MakeDataset(1);
+  auto catalogue = TransportCatalogue::Make();
+  for (const StopData &stop : data.stops) {
+    catalogue->addStop(stop);
+  }
+  for (const BusData &bus : data.buses) {
+    catalogue->addBus(bus);
+  }
+  const auto reference =
+      FindAll(data, *MakeRouter(*catalogue, router::RouterMode::ON_DEMAND,
+                                router::GraphModel::STOP_TO_STOP));
+  bool passed = true;
+  for (const auto model : models) {
+    for (const auto mode : modes) {
+      if (mode == router::RouterMode::ON_DEMAND &&
+          model == router::GraphModel::STOP_TO_STOP) {
+        continue;
+      }
+      const size_t mismatches = CountMismatches(
+          FindAll(data, *MakeRouter(*catalogue, mode, model)), reference);
+      if (mismatches != 0) {
+        cerr << "mode " << static_cast<int>(mode) << ", model "
+             << static_cast<int>(model) << ": " << mismatches
+             << " routes differ from Dijkstra" << endl;
+        passed = false;
+      }
+    }
+  }
+  return passed ? 0 : 1;
+}
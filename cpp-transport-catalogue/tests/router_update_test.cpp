@@ -0,0 +1,177 @@
+// Проверка TransportRouter::UpdateBus: маршрутизатор, дополненный автобусами
+// и изменёнными расстояниями после построения, должен находить те же
+// маршруты, что и построенный заново по итоговому справочнику.
+//
+// Через JSON этот путь недоступен: разделы входа обрабатываются до запросов
+// маршрутов, поэтому он проверяется напрямую на случайном справочнике.
+// Покрываются добавление автобуса с новыми остановками (рост таблиц),
+// уменьшение весов (релаксация рёбер) и их увеличение (перестроение)
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace transport;
+
+namespace {
+inline constexpr size_t STOP_COUNT = 40;
+inline constexpr size_t BUS_COUNT = 16;
+inline constexpr size_t CHANGE_COUNT = 10;
+
+struct Dataset {
+  // хранилище названий: справочник хранит string_view
+  deque<string> names;
+  vector<StopData> stops;
+  vector<BusData> buses;
+  // изменения расстояний после построения: новые StopData тех же остановок
+  vector<StopData> changes;
+};
+
+Dataset MakeDataset(uint32_t seed) {
+  mt19937 rng(seed);
+  Dataset data;
+  for (size_t index = 0; index < STOP_COUNT; ++index) {
+    StopData stop(data.names.emplace_back("Stop " + to_string(index)));
+    stop.coordinates = {55.5 + 0.001 * static_cast<double>(rng() % 500),
+                        37.5 + 0.001 * static_cast<double>(rng() % 500)};
+    data.stops.push_back(stop);
+  }
+  // вторая половина автобусов ходит и по остановкам, которых нет в первой,
+  // чтобы обновление добавляло вершины графа
+  for (size_t index = 0; index < BUS_COUNT; ++index) {
+    BusData bus(data.names.emplace_back("Bus " + to_string(index)));
+    const size_t stop_range =
+        index < BUS_COUNT / 2 ? STOP_COUNT / 2 : STOP_COUNT;
+    const size_t length = 3 + rng() % 6;
+    for (size_t count = 0; count < length; ++count) {
+      bus.stops.push_back(data.stops[rng() % stop_range].name);
+    }
+    bus.is_roundtrip = rng() % 2 == 0;
+    if (bus.is_roundtrip) {
+      bus.stops.push_back(bus.stops.front());
+    }
+    data.buses.push_back(bus);
+  }
+  // расстояния между соседними остановками всех автобусов
+  for (const BusData &bus : data.buses) {
+    for (size_t index = 0; index + 1 < bus.stops.size(); ++index) {
+      for (StopData &stop : data.stops) {
+        if (stop.name == bus.stops[index]) {
+          stop.road_distances[bus.stops[index + 1]] =
+              static_cast<double>(500 + rng() % 3000);
+        }
+      }
+    }
+  }
+  // половина изменений удешевляет рёбра, половина удорожает
+  for (size_t index = 0; index < CHANGE_COUNT; ++index) {
+    StopData stop = data.stops[rng() % STOP_COUNT];
+    for (auto &[name, distance] : stop.road_distances) {
+      distance = index % 2 == 0 ? max(1., distance / 3) : distance * 3;
+    }
+    data.changes.push_back(stop);
+  }
+  return data;
+}
+
+// Обновляет маршрутизатор после изменения расстояний от остановки так же, как
+// это делает AddStopQuery
+void UpdateStopBuses(const TransportCatalogue &catalogue,
+                     TransportRouter &router, string_view stop_name) {
+  const auto stop_stat = catalogue.getStopStat(stop_name);
+  for (const auto &bus_name : stop_stat->buses) {
+    if (const auto route = catalogue.getRouteInfo(bus_name);
+        route.has_value()) {
+      router.UpdateBus(route.value());
+    }
+  }
+}
+
+// Число пар остановок, для которых маршрутизаторы отвечают по-разному.
+// Допуск - под веса float режима PRECOMPUTED_COMPACT
+size_t CountMismatches(const Dataset &data, const TransportRouter &updated,
+                       const TransportRouter &rebuilt) {
+  size_t mismatches = 0;
+  for (const StopData &from : data.stops) {
+    for (const StopData &to : data.stops) {
+      const auto lhs = updated.FindRoute(from.name, to.name);
+      const auto rhs = rebuilt.FindRoute(from.name, to.name);
+      if (lhs.has_value() != rhs.has_value() ||
+          (lhs.has_value() &&
+           abs(lhs->total_time - rhs->total_time) >
+               1e-5 * max(1., rhs->total_time))) {
+        ++mismatches;
+      }
+    }
+  }
+  return mismatches;
+}
+
+bool RunCase(const Dataset &data, router::RouterMode mode,
+             router::GraphModel model) {
+  router::RoutingSettings settings;
+  settings.bus_wait = 2;
+  settings.bus_velocity = 30;
+  settings.mode = mode;
+  settings.graph_model = model;
+
+  // первая половина автобусов до построения, остальное - обновлениями
+  auto catalogue = TransportCatalogue::Make();
+  auto updated = TransportRouter::Make();
+  updated->SetSettings(settings);
+  for (const StopData &stop : data.stops) {
+    catalogue->addStop(stop);
+  }
+  for (size_t index = 0; index < BUS_COUNT / 2; ++index) {
+    catalogue->addBus(data.buses[index]);
+  }
+  updated->UploadData(catalogue->getStopCount(),
+                      catalogue->getRoutesInfo().value());
+  for (size_t index = BUS_COUNT / 2; index < BUS_COUNT; ++index) {
+    catalogue->addBus(data.buses[index]);
+    updated->UpdateBus(
+        catalogue->getRouteInfo(data.buses[index].name).value());
+  }
+  for (const StopData &change : data.changes) {
+    catalogue->addStop(change);
+    UpdateStopBuses(*catalogue, *updated, change.name);
+  }
+
+  auto rebuilt = TransportRouter::Make();
+  rebuilt->SetSettings(settings);
+  rebuilt->UploadData(catalogue->getStopCount(),
+                      catalogue->getRoutesInfo().value());
+
+  const size_t mismatches = CountMismatches(data, *updated, *rebuilt);
+  if (mismatches != 0) {
+    cerr << "mode " << static_cast<int>(mode) << ", model "
+         << static_cast<int>(model) << ": " << mismatches
+         << " routes differ" << endl;
+  }
+  return mismatches == 0;
+}
+} // namespace
+
+int main() {
+  const router::RouterMode modes[] = {
+      router::RouterMode::PRECOMPUTED, router::RouterMode::PRECOMPUTED_COMPACT,
+      router::RouterMode::ON_DEMAND, router::RouterMode::CONTRACTION_HIERARCHY};
+  const router::GraphModel models[] = {router::GraphModel::STOP_TO_STOP,
+                                       router::GraphModel::RIDE_VERTICES};
+  bool passed = true;
+  for (const uint32_t seed : {1U, 2U, 3U}) {
+    const Dataset data = MakeDataset(seed);
+    for (const auto mode : modes) {
+      for (const auto model : models) {
+        passed = RunCase(data, mode, model) && passed;
+      }
+    }
+  }
+  return passed ? 0 : 1;
+}
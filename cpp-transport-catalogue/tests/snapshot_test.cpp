@@ -0,0 +1,159 @@
+// Проверка двоичного снимка справочника: загруженный снимок совпадает с
+// записанным справочником, а повреждённый не оставляет частично загруженных
+// данных
+
+#include "transport_catalogue.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace transport;
+
+namespace {
+inline constexpr size_t STOP_COUNT = 12;
+inline constexpr size_t BUS_COUNT = 4;
+// смещение поля bus_stops_offset в заголовке снимка: магия и версия, затем
+// шесть счётчиков и четыре смещения по 8 байт
+inline constexpr size_t BUS_STOPS_OFFSET_FIELD = 8 + 10 * 8;
+
+// хранилище названий: справочник хранит string_view
+deque<string> names;
+vector<string_view> stop_names;
+vector<string_view> bus_names;
+
+// Остановки с расстояниями, маршруты обоих видов, маршрут без остановок и
+// остановка без координат, известная только по расстоянию до неё
+unique_ptr<TransportCatalogue> MakeCatalogue() {
+  auto catalogue = TransportCatalogue::Make();
+  stop_names.clear();
+  bus_names.clear();
+  for (size_t index = 0; index < STOP_COUNT; ++index) {
+    stop_names.push_back(names.emplace_back("Stop " + to_string(index)));
+  }
+  for (size_t index = 0; index < STOP_COUNT; ++index) {
+    StopData stop(stop_names[index]);
+    stop.coordinates = {55.6 + 0.01 * static_cast<double>(index),
+                        37.6 + 0.005 * static_cast<double>(index % 3)};
+    stop.road_distances[stop_names[(index + 1) % STOP_COUNT]] =
+        static_cast<double>(1000 + 100 * index);
+    if (index == 0) {
+      stop.road_distances[stop_names.emplace_back(
+          names.emplace_back("Far stop"))] = 5000;
+    }
+    catalogue->addStop(stop);
+  }
+  for (size_t index = 0; index < BUS_COUNT; ++index) {
+    BusData bus(
+        bus_names.emplace_back(names.emplace_back("B" + to_string(index))));
+    for (size_t stop = index; stop < index + 5; ++stop) {
+      bus.stops.push_back(stop_names[stop % STOP_COUNT]);
+    }
+    bus.is_roundtrip = index % 2 == 0;
+    if (bus.is_roundtrip) {
+      bus.stops.push_back(bus.stops.front());
+    }
+    catalogue->addBus(bus);
+  }
+  catalogue->addBus(BusData(bus_names.emplace_back("Empty")));
+  return catalogue;
+}
+
+bool Near(double lhs, double rhs) {
+  return abs(lhs - rhs) <= 1e-9 * max(1., abs(rhs));
+}
+
+map<pair<string_view, string_view>, double>
+GetDistances(const TransportCatalogue &catalogue) {
+  map<pair<string_view, string_view>, double> distances;
+  for (const StopDistance &distance : catalogue.getDistances()) {
+    distances[{distance.from, distance.to}] = distance.distance;
+  }
+  return distances;
+}
+
+bool TestRoundTrip(const string &file_name) {
+  const auto original = MakeCatalogue();
+  original->saveSnapshot(file_name);
+  auto loaded = TransportCatalogue::Make();
+  loaded->loadSnapshot(file_name);
+
+  bool passed = loaded->getStopCount() == original->getStopCount();
+  for (const string_view name : stop_names) {
+    const auto lhs = original->getStopStat(name);
+    const auto rhs = loaded->getStopStat(name);
+    passed = passed && lhs.has_value() && rhs.has_value() &&
+             lhs->buses == rhs->buses;
+  }
+  for (const string_view name : bus_names) {
+    const auto lhs = original->getBusStat(name);
+    const auto rhs = loaded->getBusStat(name);
+    passed = passed && lhs.has_value() && rhs.has_value() &&
+             lhs->stops_count == rhs->stops_count &&
+             lhs->unique_stops_count == rhs->unique_stops_count &&
+             Near(lhs->geolength, rhs->geolength) &&
+             Near(lhs->routelength, rhs->routelength);
+  }
+  const auto original_distances = GetDistances(*original);
+  const auto loaded_distances = GetDistances(*loaded);
+  passed = passed && original_distances.size() == loaded_distances.size();
+  for (const auto &[stops, distance] : original_distances) {
+    const auto iter = loaded_distances.find(stops);
+    passed = passed && iter != loaded_distances.end() &&
+             Near(iter->second, distance);
+  }
+  if (!passed) {
+    cerr << "round trip: loaded catalogue differs" << endl;
+  }
+  return passed;
+}
+
+// Номер остановки первого маршрута заменяется несуществующим
+void CorruptBusStop(const string &file_name) {
+  fstream file(file_name, ios::in | ios::out | ios::binary);
+  uint64_t bus_stops_offset = 0;
+  file.seekg(BUS_STOPS_OFFSET_FIELD);
+  file.read(reinterpret_cast<char *>(&bus_stops_offset),
+            sizeof(bus_stops_offset));
+  const uint32_t bad_stop = UINT32_MAX;
+  file.seekp(static_cast<streamoff>(bus_stops_offset));
+  file.write(reinterpret_cast<const char *>(&bad_stop), sizeof(bad_stop));
+}
+
+bool TestCorruptedSnapshot(const string &file_name) {
+  MakeCatalogue()->saveSnapshot(file_name);
+  CorruptBusStop(file_name);
+  auto catalogue = TransportCatalogue::Make();
+  try {
+    catalogue->loadSnapshot(file_name);
+    cerr << "corrupted snapshot: no error" << endl;
+    return false;
+  } catch (const runtime_error &) {
+  }
+  // остановки и маршруты до повреждённого места не должны остаться
+  if (catalogue->getStopCount() != 0 || catalogue->getBusStat("B0") ||
+      catalogue->getStopStat("Stop 0") || catalogue->getRoutesInfo()) {
+    cerr << "corrupted snapshot: catalogue is partially loaded" << endl;
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+int main() {
+  const string file_name =
+      (filesystem::temp_directory_path() / "transport_catalogue_snapshot_test")
+          .string();
+  bool passed = TestRoundTrip(file_name);
+  passed = TestCorruptedSnapshot(file_name) && passed;
+  filesystem::remove(file_name);
+  return passed ? 0 : 1;
+}
@@ -3,75 +3,168 @@
  */
 #include "transport_catalogue.h"
 #include "geo.h"
+#include "mapped_file.h"
+#include "string_pool.h"
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <execution>
 #include <functional>
 #include <iostream>
 #include <numeric>
+#include <fstream>
 #include <set>
+#include <stdexcept>
 #include <string>
 
 using namespace std;
 
 using namespace transport;
-TransportCatalogue::StopElement::StopElement(const string &name) : name(name) {}
+
+namespace {
+// поколения общие для всех справочников процесса, поэтому не повторяются
+uint64_t nextGeneration() {
+  static std::atomic<uint64_t> generation{0};
+  return ++generation;
+}
+} // namespace
+
+TransportCatalogue::StopElement::StopElement(string_view name) : name(name) {}
 
 TransportCatalogue::StopElement::StopElement(
-    const std::string &name, const detail::Coordinates coordinates)
+    string_view name, const detail::Coordinates coordinates)
     : name(name), coordinates(coordinates) {}
 
-TransportCatalogue::BusElement::BusElement(
-    const string &name, const std::vector<StopElement *> &stops)
+TransportCatalogue::BusElement::BusElement(string_view name,
+                                           const std::vector<StopId> &stops)
     : name(name), stops(stops) {}
 
+/*--------------------------- RouteView -------------------------------------*/
+TransportCatalogue::RouteView::RouteView(const std::deque<StopElement> &stops,
+                                         const BusElement &bus,
+                                         const DistanceMap &routeDistances)
+    : stops_(&stops), bus_(&bus), routeDistances_(&routeDistances) {}
+
+StopInfo TransportCatalogue::RouteView::stopAt(size_t index) const {
+  const StopElement &stop = (*stops_)[bus_->stops[index]];
+  return {stop.name, stop.coordinates.value()};
+}
+
+double TransportCatalogue::RouteView::segmentDistance(size_t from_index,
+                                                      size_t to_index) const {
+  return GetRouteDistance(*routeDistances_)(bus_->stops[from_index],
+                                            bus_->stops[to_index]);
+}
+
+/*--------------------------- RoutesView ------------------------------------*/
+TransportCatalogue::RoutesView::RoutesView(
+    const std::deque<StopElement> &stops, const std::deque<BusElement> &buses,
+    const DistanceMap &routeDistances)
+    : stops_(&stops), buses_(&buses), routeDistances_(&routeDistances) {}
+
+TransportCatalogue::RoutesView::Iterator::Iterator(const RoutesView &routes,
+                                                   size_t index)
+    : stops_(routes.stops_), buses_(routes.buses_),
+      routeDistances_(routes.routeDistances_), index_(index) {
+  skipEmpty_();
+}
+
+TransportCatalogue::RouteView
+TransportCatalogue::RoutesView::Iterator::operator*() const {
+  return {*stops_, (*buses_)[index_], *routeDistances_};
+}
+
+TransportCatalogue::RoutesView::Iterator &
+TransportCatalogue::RoutesView::Iterator::operator++() {
+  ++index_;
+  skipEmpty_();
+  return *this;
+}
+
+void TransportCatalogue::RoutesView::Iterator::skipEmpty_() {
+  while (index_ < buses_->size() && (*buses_)[index_].stops.empty()) {
+    ++index_;
+  }
+}
+
+/*--------------------------- DistancesView ---------------------------------*/
+StopDistance TransportCatalogue::DistancesView::Iterator::operator*() const {
+  const auto &[stops_pair, distance] = *iter_;
+  return {(*stops_)[stops_pair.first].name, (*stops_)[stops_pair.second].name,
+          distance};
+}
+
 std::unique_ptr<TransportCatalogue> TransportCatalogue::Make() {
   return std::make_unique<TransportCatalogueImpl>();
 }
 
 void TransportCatalogueImpl::addBus(const BusData &data) {
 
-  vector<StopElement *> bus_stops;
+  vector<StopId> bus_stops;
   bus_stops.reserve(data.stops.size());
 
-  for_each(
-      data.stops.begin(), data.stops.end(),
-      [this, &data, &bus_stops](const std::string &stop_name) {
-        bus_stops.emplace_back(getStop_(stop_name))->buses.emplace(data.name);
-      });
+  transform(data.stops.begin(), data.stops.end(), back_inserter(bus_stops),
+            [this](std::string_view stop_name) {
+              return getStop_(stop_name);
+            });
+  addBus_(data.name, bus_stops, data.is_roundtrip);
+  //  cout << "New Bus "sv << data.name << " was added"sv << endl;
+}
 
-  BusElement &new_bus = buses_.emplace_back(data.name, bus_stops);
+void TransportCatalogueImpl::addBus_(std::string_view name,
+                                     const std::vector<StopId> &stops,
+                                     bool is_roundtrip) {
+  const auto bus_id = static_cast<BusId>(buses_.size());
+  for (const StopId stop_id : stops) {
+    // номер нового маршрута больше всех прежних, повтор возможен только
+    // в конце
+    if (auto &buses = stops_[stop_id].buses;
+        buses.empty() || buses.back() != bus_id) {
+      buses.push_back(bus_id);
+    }
+  }
+  BusElement &new_bus = buses_.emplace_back(detail::Intern(name), stops);
+  finalized_ = false;
+  generation_ = nextGeneration();
 
-  new_bus.is_roundtrip = data.is_roundtrip;
-  busesIndex_.emplace(new_bus.name, &new_bus);
-  //  cout << "New Bus "sv << data.name << " was added"sv << endl;
+  new_bus.is_roundtrip = is_roundtrip;
+  busesIndex_.emplace(new_bus.name, bus_id);
 }
 
-TransportCatalogue::StopElement *
+TransportCatalogue::StopId
 TransportCatalogueImpl::getStop_(std::string_view stop_name) {
   if (auto iter = stops_index_.find(stop_name); iter != stops_index_.end()) {
     return iter->second;
   }
-  StopElement *new_stop = &stops_.emplace_back(string(stop_name));
-  stops_index_.emplace(new_stop->name, new_stop);
-  return new_stop;
+  const auto stop_id = static_cast<StopId>(stops_.size());
+  const StopElement &new_stop = stops_.emplace_back(detail::Intern(stop_name));
+  stops_index_.emplace(new_stop.name, stop_id);
+  return stop_id;
 }
 
 void TransportCatalogueImpl::addStop(const StopData &stop_data) {
-  StopElement *stop = getStop_(stop_data.name);
+  const StopId stop = getStop_(stop_data.name);
+  finalized_ = false;
+  generation_ = nextGeneration();
   // остановка обновлена или создана
-  stop->coordinates.emplace(stop_data.coordinates);
+  stops_[stop].coordinates.emplace(stop_data.coordinates);
   // добавляю данные в routeDistances_, попутно создавая новые остановки
   if (!stop_data.road_distances.empty()) {
     for (const auto &[stop_name, distance] : stop_data.road_distances) {
-      StopElement *nearbyStop = getStop_(stop_name);
+      const StopId nearbyStop = getStop_(stop_name);
       routeDistances_[{stop, nearbyStop}] = distance;
     }
   }
   //  cout << "New Stop " << data.name << " was added" << endl;
 }
 
-optional<TransportCatalogue::BusElement *>
-TransportCatalogueImpl::findBus(const std::string &bus_name) const {
+optional<TransportCatalogue::BusId>
+TransportCatalogueImpl::findBus(string_view bus_name) const {
   if (auto iter = busesIndex_.find(bus_name); iter != busesIndex_.end()) {
     return {iter->second};
   }
@@ -79,134 +172,399 @@ TransportCatalogueImpl::findBus(const std::string &bus_name) const {
 }
 
 optional<BusStat>
-TransportCatalogueImpl::getBusStat(const std::string &bus_name) const {
+TransportCatalogueImpl::getBusStat(string_view bus_name) const {
   if (auto iter = busesIndex_.find(bus_name); iter != busesIndex_.end()) {
-    vector<StopElement *> stops(iter->second->stops);
-
-    vector<double> geoDistances{};
-    /* согласно рекомендации @Савва: "Агрегатная и временная информация
-    не должна считаться просто так. Если был запрос на информацию о остановке ли
-    маршруте: считаем кол-во остановок, длину маршрута, кривизну итд"
-    (https://yandex-students.slack.com/archives/C02T0G67PC4/p1654018639507289?thread_ts=1652686559.771829&cid=C02T0G67PC4)
-    и продолжение: "Да, получается, что если мы запросили информацию только об
-    одном маршруте, а их 10000, то ты зря потратил время для информации для 9999
-    марщрутов"
-    (https://yandex-students.slack.com/archives/C02T0G67PC4/p1654019099579329?thread_ts=1652686559.771829&cid=C02T0G67PC4)
-    */
-    // При большом количестве запросов расстояния между остановками уже будут
-    // посчитаны и сохранены в geoDistances_
-    transform(stops.begin(), prev(stops.end()), next(stops.begin()),
-              back_inserter(geoDistances), GetGeoDistance(geoDistances_));
-    vector<double> route_distances{};
-    transform(stops.begin(), prev(stops.end()), next(stops.begin()),
-              back_inserter(route_distances),
-              GetRouteDistance(routeDistances_));
-    BusStat bus_info((string(bus_name)));
-
-    if (!iter->second->is_roundtrip) {
-      transform(stops.rbegin(), prev(stops.rend()), next(stops.rbegin()),
-                back_inserter(geoDistances), GetGeoDistance(geoDistances_));
-      transform(stops.rbegin(), prev(stops.rend()), next(stops.rbegin()),
-                back_inserter(route_distances),
-                GetRouteDistance(routeDistances_));
-      bus_info.stops_count = static_cast<uint>(stops.size() * 2 - 1);
-    } else {
-      bus_info.stops_count = static_cast<uint>(stops.size());
+    // после finalize статистика уже посчитана
+    if (finalized_) {
+      return {buses_[iter->second].stat};
     }
-    sort(execution::par_unseq, stops.begin(), stops.end());
-
-    auto new_end = unique(stops.begin(), stops.end());
-    stops.erase(new_end, stops.end());
-    bus_info.unique_stops_count = static_cast<uint>(stops.size());
-    bus_info.geolength =
-        reduce(execution::par_unseq, geoDistances.begin(), geoDistances.end());
-    bus_info.routelength = reduce(execution::par_unseq, route_distances.begin(),
-                                  route_distances.end());
-    return {bus_info};
+    return {makeBusStat_(buses_[iter->second])};
   }
   return nullopt;
 }
 
+void TransportCatalogueImpl::finalize() {
+  if (finalized_) {
+    return;
+  }
+  // статистика всех маршрутов считается одним параллельным проходом
+  tbb::parallel_for(size_t{0}, buses_.size(), [this](size_t index) {
+    BusElement &bus = buses_[index];
+    bus.stat = makeBusStat_(bus);
+  });
+  finalized_ = true;
+}
+
+BusStat TransportCatalogueImpl::makeBusStat_(const BusElement &bus) const {
+  // у маршрута без остановок нулевая статистика
+  if (bus.stops.empty()) {
+    return BusStat(bus.name);
+  }
+  vector<StopId> stops(bus.stops);
+
+  vector<double> geoDistances{};
+  // При большом количестве запросов расстояния между остановками уже будут
+  // посчитаны и сохранены в geoDistances_
+  transform(stops.begin(), prev(stops.end()), next(stops.begin()),
+            back_inserter(geoDistances), GetGeoDistance(stops_, geoDistances_));
+  vector<double> route_distances{};
+  transform(stops.begin(), prev(stops.end()), next(stops.begin()),
+            back_inserter(route_distances), GetRouteDistance(routeDistances_));
+  BusStat bus_info(bus.name);
+
+  if (!bus.is_roundtrip) {
+    transform(stops.rbegin(), prev(stops.rend()), next(stops.rbegin()),
+              back_inserter(geoDistances), GetGeoDistance(stops_, geoDistances_));
+    transform(stops.rbegin(), prev(stops.rend()), next(stops.rbegin()),
+              back_inserter(route_distances),
+              GetRouteDistance(routeDistances_));
+    bus_info.stops_count = static_cast<uint>(stops.size() * 2 - 1);
+  } else {
+    bus_info.stops_count = static_cast<uint>(stops.size());
+  }
+  // маршруты обрабатываются параллельно, поэтому внутри маршрута -
+  // последовательно
+  sort(stops.begin(), stops.end());
+
+  auto new_end = unique(stops.begin(), stops.end());
+  stops.erase(new_end, stops.end());
+  bus_info.unique_stops_count = static_cast<uint>(stops.size());
+  bus_info.geolength = accumulate(geoDistances.begin(), geoDistances.end(), 0.);
+  bus_info.routelength =
+      accumulate(route_distances.begin(), route_distances.end(), 0.);
+  return bus_info;
+}
+
 std::optional<StopStat>
-TransportCatalogueImpl::getStopStat(const std::string &stop_name) const {
+TransportCatalogueImpl::getStopStat(string_view stop_name) const {
   if (auto iter = stops_index_.find(stop_name); iter != stops_index_.end()) {
-    return StopStat(string(stop_name),
-                    {iter->second->buses.begin(), iter->second->buses.end()});
+    // номера маршрутов переводятся в названия только для ответа
+    const StopElement &stop = stops_[iter->second];
+    vector<string_view> buses;
+    buses.reserve(stop.buses.size());
+    transform(stop.buses.begin(), stop.buses.end(), back_inserter(buses),
+              [this](BusId bus_id) { return buses_[bus_id].name; });
+    sort(buses.begin(), buses.end());
+    buses.erase(unique(buses.begin(), buses.end()), buses.end());
+    return StopStat(stop.name, move(buses));
   }
   return nullopt;
 }
 
-std::optional<std::vector<BusInfo>>
+std::optional<TransportCatalogue::RoutesView>
 TransportCatalogueImpl::getRoutesInfo() const {
   // нужны названия маршрутов (автобусов) с перечнем их остановок (по порядку)
   // с координатами
   if (buses_.empty()) {
     return nullopt;
   }
-  std::vector<BusInfo> result;
-  result.reserve(buses_.size());
-  for (const auto &bus : buses_) {
-    if (!bus.stops.empty()) {
-      BusInfo element(bus.name);
-      element.stops.reserve(bus.stops.size());
-      transform(bus.stops.begin(), bus.stops.end(),
-                back_inserter(element.stops), [](const StopElement *stop) {
-                  return StopInfo(stop->name, stop->coordinates.value());
-                });
-
-      element.is_roundtrip = bus.is_roundtrip;
-      result.emplace_back(element);
-    }
+  return RoutesView(stops_, buses_, routeDistances_);
+}
+
+std::optional<TransportCatalogue::RouteView>
+TransportCatalogueImpl::getRouteInfo(string_view bus_name) const {
+  const auto iter = busesIndex_.find(bus_name);
+  if (iter == busesIndex_.end() || buses_[iter->second].stops.empty()) {
+    return nullopt;
   }
-  return result;
+  const BusElement &bus = buses_[iter->second];
+  // маршрут с ещё не добавленными остановками описать нельзя
+  if (!all_of(bus.stops.begin(), bus.stops.end(), [this](StopId stop_id) {
+        return stops_[stop_id].coordinates.has_value();
+      })) {
+    return nullopt;
+  }
+  return RouteView(stops_, bus, routeDistances_);
 }
 
-Distances TransportCatalogueImpl::getDistances() const {
-  Distances result{};
-  result.reserve(routeDistances_.size());
+TransportCatalogue::DistancesView
+TransportCatalogueImpl::getDistances() const {
+  return {stops_, routeDistances_};
+}
+
+size_t TransportCatalogueImpl::getStopCount() const { return stops_.size(); }
+
+uint64_t TransportCatalogueImpl::getGeneration() const { return generation_; }
+
+namespace {
+// Снимок справочника: заголовок, затем секции с выравниванием
+// SNAPSHOT_ALIGNMENT. Строки хранятся одним блоком символов и таблицей
+// {смещение, длина}; остановки, автобусы и расстояния ссылаются на строки и
+// остановки по номерам
+constexpr std::array<char, 4> SNAPSHOT_MAGIC{'T', 'C', 'S', 'N'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr size_t SNAPSHOT_ALIGNMENT = 64;
+
+struct SnapshotHeader {
+  std::array<char, 4> magic;
+  uint32_t version;
+  uint64_t string_count;
+  uint64_t char_count;
+  uint64_t stop_count;
+  uint64_t bus_count;
+  uint64_t bus_stop_count;
+  uint64_t distance_count;
+  uint64_t strings_offset;
+  uint64_t chars_offset;
+  uint64_t stops_offset;
+  uint64_t buses_offset;
+  uint64_t bus_stops_offset;
+  uint64_t distances_offset;
+  uint64_t file_size;
+};
+
+struct SnapshotString {
+  uint64_t offset;
+  uint64_t length;
+};
+
+struct SnapshotStop {
+  double latitude;
+  double longitude;
+  uint32_t name;
+  uint32_t has_coordinates;
+};
+
+struct SnapshotBus {
+  uint32_t name;
+  uint32_t is_roundtrip;
+  uint64_t first_stop;
+  uint64_t stop_count;
+};
+
+struct SnapshotDistance {
+  uint32_t from;
+  uint32_t to;
+  double distance;
+};
+
+// Раскладывает секции снимка по выровненным смещениям
+void layoutSnapshot(SnapshotHeader &header) {
+  size_t offset = sizeof(SnapshotHeader);
+  const auto place = [&offset](uint64_t &section_offset, size_t size) {
+    offset = io::AlignOffset(offset, SNAPSHOT_ALIGNMENT);
+    section_offset = offset;
+    offset += size;
+  };
+  place(header.strings_offset, header.string_count * sizeof(SnapshotString));
+  place(header.chars_offset, header.char_count);
+  place(header.stops_offset, header.stop_count * sizeof(SnapshotStop));
+  place(header.buses_offset, header.bus_count * sizeof(SnapshotBus));
+  place(header.bus_stops_offset, header.bus_stop_count * sizeof(uint32_t));
+  place(header.distances_offset,
+        header.distance_count * sizeof(SnapshotDistance));
+  header.file_size = offset;
+}
+
+[[noreturn]] void throwDamaged(const std::string &file_name) {
+  throw runtime_error("Snapshot file " + file_name + " is damaged");
+}
+
+template <typename Record>
+const Record *getSection(const io::MappedFile &file, uint64_t offset) {
+  return reinterpret_cast<const Record *>(file.GetData() + offset);
+}
+} // namespace
+
+void TransportCatalogueImpl::saveSnapshot(const std::string &file_name) const {
+  std::vector<SnapshotString> strings;
+  std::string chars;
+  const auto add_string = [&strings, &chars](string_view value) {
+    strings.push_back({chars.size(), value.size()});
+    chars += value;
+    return static_cast<uint32_t>(strings.size() - 1);
+  };
+
+  // номера остановок в снимке совпадают с номерами в справочнике
+  std::vector<SnapshotStop> stops;
+  stops.reserve(stops_.size());
+  for (const auto &stop : stops_) {
+    const detail::Coordinates coordinates =
+        stop.coordinates.value_or(detail::Coordinates{});
+    stops.push_back({coordinates.lat, coordinates.lng, add_string(stop.name),
+                     stop.coordinates.has_value() ? 1U : 0U});
+  }
+
+  std::vector<SnapshotBus> buses;
+  buses.reserve(buses_.size());
+  std::vector<uint32_t> bus_stops;
+  for (const auto &bus : buses_) {
+    buses.push_back({add_string(bus.name), bus.is_roundtrip ? 1U : 0U,
+                     bus_stops.size(), bus.stops.size()});
+    bus_stops.insert(bus_stops.end(), bus.stops.begin(), bus.stops.end());
+  }
+
+  std::vector<SnapshotDistance> distances;
+  distances.reserve(routeDistances_.size());
   for (const auto &[stops_pair, distance] : routeDistances_) {
-    result[{stops_pair.first->name, stops_pair.second->name}] = distance;
+    distances.push_back({stops_pair.first, stops_pair.second, distance});
+  }
+
+  SnapshotHeader header{};
+  header.magic = SNAPSHOT_MAGIC;
+  header.version = SNAPSHOT_VERSION;
+  header.string_count = strings.size();
+  header.char_count = chars.size();
+  header.stop_count = stops.size();
+  header.bus_count = buses.size();
+  header.bus_stop_count = bus_stops.size();
+  header.distance_count = distances.size();
+  layoutSnapshot(header);
+
+  // запись во временный файл и переименование: читатель не увидит половину
+  const std::string temp_name = file_name + ".tmp";
+  {
+    std::ofstream out(temp_name, ios::binary | ios::trunc);
+    io::WriteAt(out, 0, &header, sizeof(header));
+    io::WriteAt(out, header.strings_offset, strings.data(),
+                strings.size() * sizeof(SnapshotString));
+    io::WriteAt(out, header.chars_offset, chars.data(), chars.size());
+    io::WriteAt(out, header.stops_offset, stops.data(),
+                stops.size() * sizeof(SnapshotStop));
+    io::WriteAt(out, header.buses_offset, buses.data(),
+                buses.size() * sizeof(SnapshotBus));
+    io::WriteAt(out, header.bus_stops_offset, bus_stops.data(),
+                bus_stops.size() * sizeof(uint32_t));
+    io::WriteAt(out, header.distances_offset, distances.data(),
+                distances.size() * sizeof(SnapshotDistance));
+    if (!out) {
+      throw runtime_error("Can't write snapshot file " + temp_name);
+    }
+  }
+  if (std::rename(temp_name.c_str(), file_name.c_str()) != 0) {
+    throw runtime_error("Can't write snapshot file " + file_name);
   }
-  return result;
 }
 
-size_t TransportCatalogueImpl::getStopCount() const { return stops_.size(); }
+void TransportCatalogueImpl::loadSnapshot(const std::string &file_name) {
+  if (!stops_.empty() || !buses_.empty()) {
+    throw logic_error("Snapshot can be loaded only into an empty catalogue");
+  }
+  const io::MappedFile file(file_name);
+  SnapshotHeader header{};
+  if (file.GetSize() < sizeof(header)) {
+    throwDamaged(file_name);
+  }
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) {
+    throwDamaged(file_name);
+  }
+  // смещения секций должны совпасть с вычисленными по размерам
+  SnapshotHeader expected = header;
+  layoutSnapshot(expected);
+  if (std::memcmp(&expected, &header, sizeof(header)) != 0 ||
+      file.GetSize() < header.file_size) {
+    throwDamaged(file_name);
+  }
+
+  const auto *strings = getSection<SnapshotString>(file, header.strings_offset);
+  const auto *chars = getSection<char>(file, header.chars_offset);
+  const auto get_string = [&](uint32_t string_id) {
+    if (string_id >= header.string_count ||
+        strings[string_id].offset > header.char_count ||
+        strings[string_id].length >
+            header.char_count - strings[string_id].offset) {
+      throwDamaged(file_name);
+    }
+    return std::string_view(chars + strings[string_id].offset,
+                            strings[string_id].length);
+  };
+
+  const auto *stops = getSection<SnapshotStop>(file, header.stops_offset);
+  // снимок разбирается в отдельный справочник и переносится в этот только
+  // целиком: повреждение в любой секции не оставляет частично загруженных
+  // данных
+  TransportCatalogueImpl loaded;
+  std::vector<StopId> stops_by_id;
+  stops_by_id.reserve(header.stop_count);
+  loaded.stops_index_.reserve(header.stop_count);
+  for (size_t stop_id = 0; stop_id < header.stop_count; ++stop_id) {
+    // повтор названия в повреждённом снимке даёт тот же номер
+    const StopId stop = loaded.getStop_(get_string(stops[stop_id].name));
+    if (stops[stop_id].has_coordinates != 0U) {
+      loaded.stops_[stop].coordinates.emplace(
+          detail::Coordinates{stops[stop_id].latitude, stops[stop_id].longitude});
+    }
+    stops_by_id.push_back(stop);
+  }
+  const auto get_stop = [&](uint32_t stop_id) {
+    if (stop_id >= stops_by_id.size()) {
+      throwDamaged(file_name);
+    }
+    return stops_by_id[stop_id];
+  };
+
+  const auto *buses = getSection<SnapshotBus>(file, header.buses_offset);
+  const auto *bus_stops = getSection<uint32_t>(file, header.bus_stops_offset);
+  loaded.busesIndex_.reserve(header.bus_count);
+  for (size_t bus_id = 0; bus_id < header.bus_count; ++bus_id) {
+    const SnapshotBus &bus = buses[bus_id];
+    if (bus.first_stop > header.bus_stop_count ||
+        bus.stop_count > header.bus_stop_count - bus.first_stop) {
+      throwDamaged(file_name);
+    }
+    std::vector<StopId> route;
+    route.reserve(bus.stop_count);
+    transform(bus_stops + bus.first_stop,
+              bus_stops + bus.first_stop + bus.stop_count,
+              back_inserter(route), get_stop);
+    loaded.addBus_(get_string(bus.name), route, bus.is_roundtrip != 0U);
+  }
 
-TransportCatalogueImpl::GetGeoDistance::GetGeoDistance(DistanceMap &distances)
-    : distances_(distances) {}
+  const auto *distances =
+      getSection<SnapshotDistance>(file, header.distances_offset);
+  loaded.routeDistances_.reserve(header.distance_count);
+  for (size_t index = 0; index < header.distance_count; ++index) {
+    loaded.routeDistances_[{get_stop(distances[index].from),
+                            get_stop(distances[index].to)}] =
+        distances[index].distance;
+  }
+
+  // deque при обмене сохраняет адреса названий, на которые ссылаются индексы
+  stops_.swap(loaded.stops_);
+  stops_index_.swap(loaded.stops_index_);
+  buses_.swap(loaded.buses_);
+  busesIndex_.swap(loaded.busesIndex_);
+  routeDistances_.swap(loaded.routeDistances_);
+  finalized_ = false;
+  generation_ = nextGeneration();
+}
+
+TransportCatalogueImpl::GetGeoDistance::GetGeoDistance(
+    const std::deque<StopElement> &stops, GeoDistanceMap &distances)
+    : stops_(stops), distances_(distances) {}
 
 double TransportCatalogueImpl::GetGeoDistance::operator()(
-    const StopElement *firstStop, const StopElement *secondStop) const {
+    StopId firstStop, StopId secondStop) const {
   double result = .0;
-  if (!firstStop->coordinates || !secondStop->coordinates) {
+  const auto &first_coordinates = stops_[firstStop].coordinates;
+  const auto &second_coordinates = stops_[secondStop].coordinates;
+  if (!first_coordinates || !second_coordinates) {
     return result;
   }
-
-  if (const auto iter = distances_.find({firstStop, secondStop});
-      iter != distances_.end()) {
+  const StopIdPair key = firstStop < secondStop
+                             ? StopIdPair{firstStop, secondStop}
+                             : StopIdPair{secondStop, firstStop};
+  if (const auto iter = distances_.find(key); iter != distances_.end()) {
     result = iter->second;
     return result;
   }
 
-  // рассчитать расстояние сначала обтратное расстояние
-  result = detail::ComputeDistance(secondStop->coordinates.value(),
-                                   firstStop->coordinates.value());
-  distances_.emplace(std::make_pair(secondStop, firstStop), result);
-
-  // потом прямое - искомое
-  result = detail::ComputeDistance(firstStop->coordinates.value(),
-                                   secondStop->coordinates.value());
-  distances_.emplace(std::make_pair(firstStop, secondStop), result);
+  // одновременно посчитанные для одной пары значения совпадают, поэтому
+  // неудачная вставка ничего не теряет
+  result = detail::ComputeDistance(first_coordinates.value(),
+                                   second_coordinates.value());
+  distances_.emplace(key, result);
 
   return result;
 }
 
-TransportCatalogueImpl::GetRouteDistance::GetRouteDistance(
+TransportCatalogue::GetRouteDistance::GetRouteDistance(
     const DistanceMap &routeDistances)
     : routeDistances_(routeDistances) {}
 
-double TransportCatalogueImpl::GetRouteDistance::operator()(
-    const StopElement *firstStop, const StopElement *secondStop) const {
+double TransportCatalogue::GetRouteDistance::operator()(
+    StopId firstStop, StopId secondStop) const {
   if (routeDistances_.empty()) {
     return 0.;
   }
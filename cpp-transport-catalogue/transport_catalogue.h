@@ -2,7 +2,12 @@
 
 #include "domain.h"
 #include "geo.h"
+#include <tbb/concurrent_unordered_map.h>
+
+#include <cstdint>
+#include <deque>
 #include <iomanip>
+#include <iterator>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -13,58 +18,215 @@ using namespace std::string_literals;
 using namespace transport;
 
 class TransportCatalogue {
+public:
+  // плотные номера остановок и маршрутов в порядке добавления
+  using StopId = uint32_t;
+  using BusId = uint32_t;
+  using StopIdPair = std::pair<StopId, StopId>;
+  using DistanceMap =
+      std::unordered_map<StopIdPair, double, detail::pair_hash>;
+
 protected:
   struct StopElement {
     StopElement() = default;
-    explicit StopElement(const std::string & name);
-    explicit StopElement(const std::string & , detail::Coordinates);
-    const std::string name{};
+    explicit StopElement(std::string_view name);
+    explicit StopElement(std::string_view, detail::Coordinates);
+    // название из пула строк
+    const std::string_view name{};
     std::optional<detail::Coordinates> coordinates{};
-    std::set<std::string> buses{};
+    // маршруты через остановку по возрастанию номеров, без повторов
+    std::vector<BusId> buses{};
   };
 
   struct BusElement {
     BusElement() = default;
-    explicit BusElement(const std::string & name,
-                        const std::vector<StopElement *> &);
-    const std::string name{};
+    explicit BusElement(std::string_view name, const std::vector<StopId> &);
+    // название из пула строк
+    const std::string_view name{};
     // вектор с остановками по маршруту автобуса, vector - важен порядок
-    const std::vector<StopElement *> stops{};
+    const std::vector<StopId> stops{};
     unsigned long routelength = 0;
     bool is_roundtrip{};
+    // статистика маршрута, действительна после finalize
+    BusStat stat{};
+  };
+
+  // расстояние по дорогам между остановками; если в одну сторону не задано,
+  // берётся обратное
+  struct GetRouteDistance {
+    explicit GetRouteDistance(const DistanceMap &routeDistances);
+    double operator()(StopId firstStop, StopId secondStop) const;
+
+  private:
+    const DistanceMap &routeDistances_;
   };
 
 public:
+  // Представления хранилища справочника: читают его контейнеры на месте, без
+  // выделения памяти. Действительны, пока жив справочник; добавленные позже
+  // остановки и расстояния видны через уже полученные представления
+
+  // Маршрут: остановки по порядку и расстояния между соседними
+  class RouteView {
+  public:
+    RouteView(const std::deque<StopElement> &stops, const BusElement &bus,
+              const DistanceMap &routeDistances);
+
+    [[nodiscard]] std::string_view name() const { return bus_->name; }
+    [[nodiscard]] bool isRoundtrip() const { return bus_->is_roundtrip; }
+    // число остановок маршрута в прямом направлении
+    [[nodiscard]] size_t size() const { return bus_->stops.size(); }
+    // index-я остановка маршрута, её координаты должны быть заданы
+    [[nodiscard]] StopInfo stopAt(size_t index) const;
+    // расстояние по дорогам от from_index-й до to_index-й остановки
+    [[nodiscard]] double segmentDistance(size_t from_index,
+                                         size_t to_index) const;
+
+  private:
+    const std::deque<StopElement> *stops_;
+    const BusElement *bus_;
+    const DistanceMap *routeDistances_;
+  };
+
+  // Все маршруты с остановками в порядке добавления
+  class RoutesView {
+  public:
+    class Iterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = RouteView;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = RouteView;
+
+      Iterator(const RoutesView &routes, size_t index);
+      RouteView operator*() const;
+      Iterator &operator++();
+      bool operator==(const Iterator &other) const {
+        return index_ == other.index_;
+      }
+      bool operator!=(const Iterator &other) const {
+        return !(*this == other);
+      }
+
+    private:
+      // итератор не ссылается на само представление, оно может быть
+      // временным
+      const std::deque<StopElement> *stops_;
+      const std::deque<BusElement> *buses_;
+      const DistanceMap *routeDistances_;
+      size_t index_;
+      // пропуск маршрутов без остановок
+      void skipEmpty_();
+    };
+
+    RoutesView(const std::deque<StopElement> &stops,
+               const std::deque<BusElement> &buses,
+               const DistanceMap &routeDistances);
+    [[nodiscard]] Iterator begin() const { return {*this, 0}; }
+    [[nodiscard]] Iterator end() const { return {*this, buses_->size()}; }
+
+  private:
+    const std::deque<StopElement> *stops_;
+    const std::deque<BusElement> *buses_;
+    const DistanceMap *routeDistances_;
+  };
+
+  // Измеренные расстояния между остановками
+  class DistancesView {
+  public:
+    class Iterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = StopDistance;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = StopDistance;
+
+      Iterator(const std::deque<StopElement> &stops,
+               DistanceMap::const_iterator iter)
+          : stops_(&stops), iter_(iter) {}
+      StopDistance operator*() const;
+      Iterator &operator++() {
+        ++iter_;
+        return *this;
+      }
+      bool operator==(const Iterator &other) const {
+        return iter_ == other.iter_;
+      }
+      bool operator!=(const Iterator &other) const {
+        return !(*this == other);
+      }
+
+    private:
+      const std::deque<StopElement> *stops_;
+      DistanceMap::const_iterator iter_;
+    };
+
+    DistancesView(const std::deque<StopElement> &stops,
+                  const DistanceMap &routeDistances)
+        : stops_(&stops), routeDistances_(&routeDistances) {}
+    [[nodiscard]] Iterator begin() const {
+      return {*stops_, routeDistances_->begin()};
+    }
+    [[nodiscard]] Iterator end() const {
+      return {*stops_, routeDistances_->end()};
+    }
+    [[nodiscard]] size_t size() const { return routeDistances_->size(); }
+
+  private:
+    const std::deque<StopElement> *stops_;
+    const DistanceMap *routeDistances_;
+  };
+
   virtual ~TransportCatalogue() = default;
 
   virtual void addBus(const BusData &) = 0;
 
   virtual void addStop(const StopData &) = 0;
 
-  virtual std::optional<BusElement *> findBus(const std::string &) const = 0;
+  virtual std::optional<BusId> findBus(std::string_view) const = 0;
 
 //  virtual std::optional<StopElement *> findStop(std::string_view) const = 0;
 
-  virtual std::optional<BusStat> getBusStat(const std::string &) const = 0;
+  virtual std::optional<BusStat> getBusStat(std::string_view) const = 0;
+
+  virtual std::optional<StopStat> getStopStat(std::string_view) const = 0;
 
-  virtual std::optional<StopStat> getStopStat(const std::string &) const = 0;
+  virtual std::optional<RoutesView> getRoutesInfo() const = 0;
 
-  virtual std::optional<std::vector<BusInfo>> getRoutesInfo() const = 0;
+  virtual std::optional<RouteView> getRouteInfo(std::string_view) const = 0;
 
-  virtual Distances getDistances() const = 0;
+  virtual DistancesView getDistances() const = 0;
 
   virtual size_t getStopCount() const = 0;
 
+  // Заранее считает статистику всех маршрутов, после чего getBusStat только
+  // возвращает готовое значение. Любое добавление остановки или маршрута
+  // возвращает справочник к вычислению статистики при запросе
+  virtual void finalize() = 0;
+
+  // Поколение данных: новое значение, не встречавшееся ни у одного
+  // справочника процесса, при каждом добавлении остановки, маршрута или
+  // загрузке снимка. По нему потребители проверяют актуальность кэшей
+  [[nodiscard]] virtual uint64_t getGeneration() const = 0;
+
+  // Двоичный снимок справочника: запись и загрузка через отображение файла в
+  // память. Загружать можно только в пустой справочник. При ошибке чтения или
+  // записи бросается std::runtime_error, справочник при этом остаётся пустым
+  virtual void saveSnapshot(const std::string &) const = 0;
+
+  virtual void loadSnapshot(const std::string &) = 0;
+
   static std::unique_ptr<TransportCatalogue> Make();
 };
 
 class TransportCatalogueImpl : public TransportCatalogue {
 public:
   // алиасы
-  using StopPtrPair =
-      std::pair<const StopElement *const, const StopElement *const>;
-  using DistanceMap =
-      std::unordered_map<StopPtrPair, double, detail::pair_hash>;
+  // вставка и поиск без блокировок, можно заполнять из нескольких потоков
+  using GeoDistanceMap =
+      tbb::concurrent_unordered_map<StopIdPair, double, detail::pair_hash>;
 
   explicit TransportCatalogueImpl() = default;
 
@@ -72,54 +234,67 @@ public:
 
   void addStop(const StopData &) override;
 
-  std::optional<BusElement *> findBus(const std::string &) const override;
+  std::optional<BusId> findBus(std::string_view) const override;
 
 //  std::optional<StopElement *> findStop(std::string_view) const override;
 
-  std::optional<BusStat> getBusStat(const std::string &) const override;
+  std::optional<BusStat> getBusStat(std::string_view) const override;
+
+  std::optional<StopStat> getStopStat(std::string_view) const override;
 
-  std::optional<StopStat> getStopStat(const std::string &) const override;
+  std::optional<RoutesView> getRoutesInfo() const override;
 
-  std::optional<std::vector<BusInfo>> getRoutesInfo() const override;
+  std::optional<RouteView> getRouteInfo(std::string_view) const override;
 
-  Distances getDistances() const override;
+  DistancesView getDistances() const override;
 
   size_t getStopCount() const override;
 
+  void finalize() override;
+
+  [[nodiscard]] uint64_t getGeneration() const override;
+
+  void saveSnapshot(const std::string &) const override;
+
+  void loadSnapshot(const std::string &) override;
+
 private:
-  // контейнер остановок
+  // контейнер остановок, индекс в нём - номер остановки. deque сохраняет
+  // адреса названий, на которые ссылается индекс
   std::deque<StopElement> stops_;
   // индекс остановок по названию
-  std::unordered_map<std::string_view, StopElement *const> stops_index_;
-  // контейнер маршрутов
+  std::unordered_map<std::string_view, StopId> stops_index_;
+  // контейнер маршрутов, индекс в нём - номер маршрута
   std::deque<BusElement> buses_;
   // индекс маршрутов по названию
-  std::unordered_map<std::string_view, BusElement *const> busesIndex_;
-  // расстояния вычисленные (географические по координатам)
-  mutable DistanceMap geoDistances_;
+  std::unordered_map<std::string_view, BusId> busesIndex_;
+  // расстояния вычисленные (географические по координатам); кэш заполняется
+  // из константных запросов, которые могут выполняться параллельно. Расстояние
+  // симметрично, поэтому пара остановок хранится один раз, по возрастанию
+  // номеров
+  mutable GeoDistanceMap geoDistances_;
   // расстояния измеренные (по одометру)
   DistanceMap routeDistances_;
+  // статистика маршрутов посчитана и актуальна
+  bool finalized_{};
+  // поколение данных, см. getGeneration
+  uint64_t generation_{};
 
-  StopElement *getStop_(std::string_view);
+  StopId getStop_(std::string_view);
 
-  // функторы
+  void addBus_(std::string_view, const std::vector<StopId> &, bool);
 
-  struct GetGeoDistance {
-    explicit GetGeoDistance(DistanceMap &distances);
-    double operator()(const StopElement *firstStop,
-                      const StopElement *secondStop) const;
+  BusStat makeBusStat_(const BusElement &) const;
 
-  private:
-    DistanceMap &distances_;
-  };
+  // функторы
 
-  struct GetRouteDistance {
-    explicit GetRouteDistance(
-        const DistanceMap &routeDistances);
-    double operator()(const StopElement *firstStop,
-                      const StopElement *secondStop) const;
+  struct GetGeoDistance {
+    GetGeoDistance(const std::deque<StopElement> &stops,
+                   GeoDistanceMap &distances);
+    double operator()(StopId firstStop, StopId secondStop) const;
 
   private:
-    const DistanceMap &routeDistances_;
+    const std::deque<StopElement> &stops_;
+    GeoDistanceMap &distances_;
   };
 };
@@ -1,6 +1,15 @@
 #include "transport_router.h"
+#include "mapped_file.h"
+#include <array>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <execution>
+#include <fstream>
+#include <iostream>
 #include <numeric>
+#include <stdexcept>
+#include <type_traits>
 
 using namespace std;
 using namespace transport;
@@ -18,36 +27,402 @@ void TransportRouterImpl::SetSettings(
   settings_ = settings;
 }
 
-bool TransportRouterImpl::IsReady() { return !edge_index_.empty(); }
+bool TransportRouterImpl::IsReady() {
+  return graph_ != nullptr && graph_->GetEdgeCount() > 0;
+}
+
+namespace {
+// Сохраняет описание ребра: дописывает новое или заменяет перезаписанное
+template <typename Info>
+void StoreEdgeInfo(std::vector<Info> &infos, EdgeId edge_id, Info info) {
+  if (edge_id < infos.size()) {
+    infos[edge_id] = std::move(info);
+    return;
+  }
+  assert(edge_id == infos.size());
+  infos.push_back(std::move(info));
+}
+
+// Файл таблиц маршрутизатора: заголовок, затем с выравниванием TABLE_ALIGNMENT
+// матрица весов и матрица последних рёбер маршрутов в формате Router.
+// Контрольная сумма таблиц в заголовке отсекает испорченный файл
+constexpr std::array<char, 4> ROUTER_FILE_MAGIC{'T', 'C', 'R', 'T'};
+constexpr uint32_t ROUTER_FILE_VERSION = 2;
+constexpr size_t TABLE_ALIGNMENT = 64;
+
+struct RouterFileHeader {
+  std::array<char, 4> magic;
+  uint32_t version;
+  uint64_t fingerprint;
+  uint64_t checksum;
+  uint64_t vertex_count;
+  uint32_t weight_size;
+  uint32_t edge_id_size;
+};
+
+// Смещения таблиц в файле
+struct RouterFileLayout {
+  RouterFileLayout(size_t vertex_count, size_t weight_size,
+                   size_t edge_id_size)
+      : weights_offset(io::AlignOffset(sizeof(RouterFileHeader),
+                                       TABLE_ALIGNMENT)),
+        prev_edges_offset(io::AlignOffset(
+            weights_offset + vertex_count * vertex_count * weight_size,
+            TABLE_ALIGNMENT)),
+        file_size(prev_edges_offset +
+                  vertex_count * vertex_count * edge_id_size) {}
+  size_t weights_offset;
+  size_t prev_edges_offset;
+  size_t file_size;
+};
+
+// Хэш FNV-1a по байтам значений
+class Fingerprint {
+public:
+  template <typename Type> void Add(const Type &value) {
+    static_assert(std::is_trivially_copyable_v<Type>);
+    std::array<unsigned char, sizeof(Type)> bytes{};
+    std::memcpy(bytes.data(), &value, sizeof(Type));
+    for (const unsigned char byte : bytes) {
+      hash_ = (hash_ ^ byte) * 1099511628211ULL;
+    }
+  }
+  // Добавляет блок памяти словами по 8 байт: на таблицах в сотни мегабайт
+  // побайтовый хэш заметно медленнее
+  void AddBytes(const void *data, size_t size) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (; size >= sizeof(uint64_t);
+         bytes += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+      uint64_t word{};
+      std::memcpy(&word, bytes, sizeof(word));
+      hash_ = (hash_ ^ word) * 1099511628211ULL;
+    }
+    for (; size > 0; ++bytes, --size) {
+      hash_ = (hash_ ^ *bytes) * 1099511628211ULL;
+    }
+  }
+  [[nodiscard]] uint64_t Get() const { return hash_; }
+
+private:
+  uint64_t hash_{14695981039346656037ULL};
+};
+
+// Контрольная сумма матриц весов и последних рёбер
+template <typename StoredWeight, typename StoredEdgeId>
+uint64_t TablesChecksum(const StoredWeight *weights,
+                        const StoredEdgeId *prev_edges, size_t vertex_count) {
+  const size_t cell_count = vertex_count * vertex_count;
+  Fingerprint checksum;
+  checksum.AddBytes(weights, cell_count * sizeof(StoredWeight));
+  checksum.AddBytes(prev_edges, cell_count * sizeof(StoredEdgeId));
+  return checksum.Get();
+}
+
+template <typename RouterType>
+bool WriteRouterFile(const std::string &path, const RouterType &router,
+                     uint64_t fingerprint) {
+  using StoredWeight = typename RouterType::StoredWeight;
+  using StoredEdgeId = typename RouterType::StoredEdgeId;
+  const size_t vertex_count = router.GetVertexCount();
+  const RouterFileLayout layout(vertex_count, sizeof(StoredWeight),
+                                sizeof(StoredEdgeId));
+  const RouterFileHeader header{
+      ROUTER_FILE_MAGIC,
+      ROUTER_FILE_VERSION,
+      fingerprint,
+      TablesChecksum(router.GetWeights(), router.GetPrevEdges(), vertex_count),
+      vertex_count,
+      sizeof(StoredWeight),
+      sizeof(StoredEdgeId)};
+  // запись во временный файл и переименование: читатель не увидит половину
+  const std::string temp_path = path + ".tmp";
+  {
+    std::ofstream out(temp_path, ios::binary | ios::trunc);
+    io::WriteAt(out, 0, &header, sizeof(header));
+    io::WriteAt(out, layout.weights_offset, router.GetWeights(),
+                vertex_count * vertex_count * sizeof(StoredWeight));
+    io::WriteAt(out, layout.prev_edges_offset, router.GetPrevEdges(),
+                vertex_count * vertex_count * sizeof(StoredEdgeId));
+    // ошибка записи на диск может проявиться только при сбросе буфера
+    out.close();
+    if (!out) {
+      std::remove(temp_path.c_str());
+      return false;
+    }
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Отображает файл таблиц в память и создаёт маршрутизатор над ним без
+// копирования. nullptr - файла нет, он не подходит к графу или испорчен
+template <typename RouterType>
+std::unique_ptr<RouterType>
+ReadRouterFile(const std::string &path,
+               const graph::DirectedWeightedGraph<double> &graph,
+               uint64_t fingerprint) {
+  using StoredWeight = typename RouterType::StoredWeight;
+  using StoredEdgeId = typename RouterType::StoredEdgeId;
+  std::shared_ptr<const io::MappedFile> file;
+  try {
+    file = std::make_shared<const io::MappedFile>(path);
+  } catch (const std::runtime_error &) {
+    return nullptr;
+  }
+  RouterFileHeader header{};
+  if (file->GetSize() < sizeof(header)) {
+    return nullptr;
+  }
+  std::memcpy(&header, file->GetData(), sizeof(header));
+  const size_t vertex_count = graph.GetVertexCount();
+  if (header.magic != ROUTER_FILE_MAGIC ||
+      header.version != ROUTER_FILE_VERSION ||
+      header.fingerprint != fingerprint ||
+      header.vertex_count != vertex_count ||
+      header.weight_size != sizeof(StoredWeight) ||
+      header.edge_id_size != sizeof(StoredEdgeId)) {
+    return nullptr;
+  }
+  const RouterFileLayout layout(vertex_count, sizeof(StoredWeight),
+                                sizeof(StoredEdgeId));
+  if (file->GetSize() < layout.file_size) {
+    return nullptr;
+  }
+  const auto *weights = reinterpret_cast<const StoredWeight *>(
+      file->GetData() + layout.weights_offset);
+  const auto *prev_edges = reinterpret_cast<const StoredEdgeId *>(
+      file->GetData() + layout.prev_edges_offset);
+  if (header.checksum != TablesChecksum(weights, prev_edges, vertex_count)) {
+    return nullptr;
+  }
+  try {
+    return std::make_unique<RouterType>(graph, weights, prev_edges,
+                                        std::move(file));
+  } catch (const std::invalid_argument &) {
+    return nullptr;
+  }
+}
+
+using ExactRouter = graph::Router<double>;
+using CompactRouter =
+    graph::Router<double, graph::CompactRouteStorage<double>>;
+} // namespace
+
 
-void TransportRouterImpl::UploadData(size_t stops_count,
-                                     const vector<BusInfo> &buses_info,
-                                     const Distances &distances) {
+void TransportRouterImpl::UploadData(
+    size_t stops_count, const TransportCatalogue::RoutesView &routes) {
   vertex_index_.clear();
   edge_index_.clear();
+  ride_edges_.clear();
+  bus_edges_.clear();
 
   // Загрузка данных в graph_
-  //  size_t vertex_count = std::transform_reduce(
-  //      execution::par, buses_info.begin(), buses_info.end(), 0UL, plus<>{},
-  //      [](const BusInfo &bus_info) { return bus_info.stops.size(); });
   vertex_index_.reserve(stops_count);
-  edge_index_.reserve(distances.size());
-  graph_ = std::make_unique<graph::DirectedWeightedGraph<double>>(stops_count);
-  for_each(buses_info.begin(), buses_info.end(), [&](const BusInfo &bus_info) {
-    FillGraph<std::vector<StopInfo>::const_iterator>(
-        bus_info.name, bus_info.stops.begin(), bus_info.stops.end(), distances);
-    if (!bus_info.is_roundtrip) {
-      FillGraph<std::vector<StopInfo>::const_reverse_iterator>(
-          bus_info.name, bus_info.stops.rbegin(), bus_info.stops.rend(),
-          distances);
+  graph_ = std::make_unique<graph::DirectedWeightedGraph<double>>();
+  for (const TransportCatalogue::RouteView route : routes) {
+    AddBus(route);
+  }
+  if (settings_.router_file.empty()) {
+    MakeRouter();
+  } else if (!LoadRouter()) {
+    MakeRouter();
+    // ответы от этого не меняются, но следующий запуск снова будет строить
+    // таблицы - об этом надо знать. stdout занят ответами
+    if (!SaveRouter()) {
+      std::cerr << "Failed to write router file '" << settings_.router_file
+                << "'" << std::endl;
+    }
+  }
+}
+
+void TransportRouterImpl::UpdateBus(
+    const TransportCatalogue::RouteView &route) {
+  if (!IsReady()) {
+    // граф ещё не построен, автобус попадёт в него при загрузке
+    return;
+  }
+  const auto iter = bus_edges_.find(route.name());
+  if (iter == bus_edges_.end()) {
+    const EdgeId first_edge = graph_->GetEdgeCount();
+    AddBus(route);
+    UpdateRouter(first_edge, graph_->GetEdgeCount(), false);
+    return;
+  }
+  // рёбра рейсов перезаписываются в том порядке, в котором были добавлены
+  const BusEdges bus_edges = iter->second;
+  std::vector<double> old_weights;
+  old_weights.reserve(bus_edges.last_edge - bus_edges.first_edge);
+  for (EdgeId edge_id = bus_edges.first_edge; edge_id < bus_edges.last_edge;
+       ++edge_id) {
+    old_weights.push_back(graph_->GetEdge(edge_id).weight);
+  }
+  rewrite_edge_ = bus_edges.first_edge;
+  FillBus(route, bus_edges.first_ride_vertex);
+  assert(rewrite_edge_ == bus_edges.last_edge);
+  rewrite_edge_.reset();
+
+  bool changed{false};
+  bool increased{false};
+  for (EdgeId edge_id = bus_edges.first_edge; edge_id < bus_edges.last_edge;
+       ++edge_id) {
+    const double old_weight = old_weights[edge_id - bus_edges.first_edge];
+    const double new_weight = graph_->GetEdge(edge_id).weight;
+    changed = changed || new_weight < old_weight || old_weight < new_weight;
+    increased = increased || old_weight < new_weight;
+  }
+  if (changed) {
+    // подорожавшие рёбра могли входить в готовые маршруты
+    UpdateRouter(bus_edges.first_edge, bus_edges.last_edge, increased);
+  }
+}
+
+void TransportRouterImpl::MakeRouter() {
+  switch (settings_.mode) {
+  case RouterMode::ON_DEMAND:
+    router_ = std::make_unique<graph::DijkstraRouter<double>>(*graph_);
+    break;
+  case RouterMode::CONTRACTION_HIERARCHY:
+    router_ =
+        std::make_unique<graph::ContractionHierarchyRouter<double>>(*graph_);
+    break;
+  case RouterMode::PRECOMPUTED:
+    router_ = std::make_unique<ExactRouter>(*graph_);
+    break;
+  case RouterMode::PRECOMPUTED_COMPACT:
+    router_ = std::make_unique<CompactRouter>(*graph_);
+    break;
+  }
+}
+
+uint64_t TransportRouterImpl::GetGraphFingerprint() const {
+  Fingerprint fingerprint;
+  fingerprint.Add(settings_.mode);
+  fingerprint.Add(settings_.graph_model);
+  fingerprint.Add(settings_.bus_wait);
+  fingerprint.Add(settings_.bus_velocity);
+  fingerprint.Add(graph_->GetVertexCount());
+  fingerprint.Add(graph_->GetEdgeCount());
+  for (EdgeId edge_id = 0; edge_id < graph_->GetEdgeCount(); ++edge_id) {
+    const auto &edge = graph_->GetEdge(edge_id);
+    fingerprint.Add(edge.from);
+    fingerprint.Add(edge.to);
+    fingerprint.Add(edge.weight);
+  }
+  return fingerprint.Get();
+}
+
+bool TransportRouterImpl::LoadRouter() {
+  std::unique_ptr<graph::RouterBase<double>> router;
+  switch (settings_.mode) {
+  case RouterMode::PRECOMPUTED:
+    router = ReadRouterFile<ExactRouter>(settings_.router_file, *graph_,
+                                         GetGraphFingerprint());
+    break;
+  case RouterMode::PRECOMPUTED_COMPACT:
+    router = ReadRouterFile<CompactRouter>(settings_.router_file, *graph_,
+                                           GetGraphFingerprint());
+    break;
+  case RouterMode::ON_DEMAND:
+  case RouterMode::CONTRACTION_HIERARCHY:
+    // в файле хранятся только таблицы режимов PRECOMPUTED*
+    break;
+  }
+  if (router == nullptr) {
+    return false;
+  }
+  router_ = std::move(router);
+  return true;
+}
+
+bool TransportRouterImpl::SaveRouter() const {
+  switch (settings_.mode) {
+  case RouterMode::PRECOMPUTED:
+    return WriteRouterFile(settings_.router_file,
+                           static_cast<const ExactRouter &>(*router_),
+                           GetGraphFingerprint());
+  case RouterMode::PRECOMPUTED_COMPACT:
+    return WriteRouterFile(settings_.router_file,
+                           static_cast<const CompactRouter &>(*router_),
+                           GetGraphFingerprint());
+  case RouterMode::ON_DEMAND:
+  case RouterMode::CONTRACTION_HIERARCHY:
+    // таблиц нет, сохранять нечего
+    break;
+  }
+  return true;
+}
+
+void TransportRouterImpl::UpdateRouter(EdgeId first_edge, EdgeId last_edge,
+                                       bool rebuild) {
+  if (rebuild || router_ == nullptr ||
+      !router_->Update(first_edge, last_edge)) {
+    MakeRouter();
+  }
+}
+
+void TransportRouterImpl::AddBus(const TransportCatalogue::RouteView &route) {
+  BusEdges bus_edges{graph_->GetEdgeCount(), graph_->GetEdgeCount(),
+                     graph_->GetVertexCount()};
+  if (settings_.graph_model == GraphModel::RIDE_VERTICES) {
+    const size_t ride_vertex_count =
+        route.size() * (route.isRoundtrip() ? 1 : 2);
+    for (size_t count = 0; count < ride_vertex_count; ++count) {
+      graph_->AddVertex();
     }
-  });
-  router_ = std::make_unique<graph::Router<double>>(*graph_);
+  }
+  FillBus(route, bus_edges.first_ride_vertex);
+  bus_edges.last_edge = graph_->GetEdgeCount();
+  bus_edges_.emplace(route.name(), bus_edges);
+}
+
+void TransportRouterImpl::FillBus(const TransportCatalogue::RouteView &route,
+                                  VertexId ride_vertex) {
+  FillTrip(route, false, ride_vertex);
+  if (!route.isRoundtrip()) {
+    FillTrip(route, true, ride_vertex);
+  }
+}
+
+void TransportRouterImpl::FillTrip(const TransportCatalogue::RouteView &route,
+                                   bool backward, VertexId &ride_vertex) {
+  // остановки читаются из справочника, в буферы попадают только названия и
+  // нарастающие суммы расстояний
+  const size_t stops_count = route.size();
+  trip_stops_.clear();
+  trip_distances_.clear();
+  for (size_t position = 0; position < stops_count; ++position) {
+    const size_t index = backward ? stops_count - 1 - position : position;
+    trip_stops_.push_back(route.stopAt(index).name);
+    trip_distances_.push_back(
+        position == 0 ? 0.
+                      : trip_distances_.back() +
+                            route.segmentDistance(
+                                backward ? index + 1 : index - 1, index));
+  }
+  if (settings_.graph_model == GraphModel::RIDE_VERTICES) {
+    FillRideGraph(route.name(), ride_vertex);
+  } else {
+    FillGraph(route.name());
+  }
+}
+
+EdgeId TransportRouterImpl::PutEdge(const graph::Edge<double> &edge) {
+  if (!rewrite_edge_) {
+    return graph_->AddEdge(edge);
+  }
+  const EdgeId edge_id = (*rewrite_edge_)++;
+  assert(graph_->GetEdge(edge_id).from == edge.from &&
+         graph_->GetEdge(edge_id).to == edge.to);
+  graph_->SetEdgeWeight(edge_id, edge.weight);
+  return edge_id;
 }
 
 std::optional<RouteStat>
-TransportRouterImpl::FindRoute(const std::string &stop_from,
-                               const std::string &stop_to) const {
+TransportRouterImpl::FindRoute(std::string_view stop_from,
+                               std::string_view stop_to) const {
 
   const auto from_iter = vertex_index_.find(stop_from);
   const auto to_iter = vertex_index_.find(stop_to);
@@ -57,25 +432,56 @@ TransportRouterImpl::FindRoute(const std::string &stop_from,
   const auto route_found(
       router_->BuildRoute(from_iter->second, to_iter->second));
 
-  if (route_found.has_value()) {
-    RouteStat result{};
-    result.total_time = route_found->weight;
-    result.items.reserve(route_found->edges.size() * 2);
-    for (const EdgeId edge_id : route_found->edges) {
-      if (const auto edge_iter = edge_index_.find(edge_id);
-          edge_iter != edge_index_.end()) {
-        const RouteItemStop stop_item{edge_iter->second.from,
-                                      settings_.bus_wait};
-        const RouteItemBus bus_item{
-            edge_iter->second.bus_name, edge_iter->second.span_count,
-            edge_iter->second.time - stop_item.wait_time};
-        result.items.emplace_back(stop_item);
-        result.items.emplace_back(bus_item);
-      }
+  if (!route_found.has_value()) {
+    return nullopt;
+  }
+  if (settings_.graph_model == GraphModel::RIDE_VERTICES) {
+    return MakeRideRouteStat(route_found.value());
+  }
+  return MakeRouteStat(route_found.value());
+}
+
+RouteStat TransportRouterImpl::MakeRouteStat(
+    const graph::RouterBase<double>::RouteInfo &route) const {
+  RouteStat result{};
+  result.total_time = route.weight;
+  result.items.reserve(route.edges.size() * 2);
+  for (const EdgeId edge_id : route.edges) {
+    const InternalEdge &edge = edge_index_[edge_id];
+    const RouteItemStop stop_item{edge.from, settings_.bus_wait};
+    const RouteItemBus bus_item{edge.bus_name, edge.span_count,
+                                edge.time - stop_item.wait_time};
+    result.items.emplace_back(stop_item);
+    result.items.emplace_back(bus_item);
+  }
+  return result;
+}
+
+RouteStat TransportRouterImpl::MakeRideRouteStat(
+    const graph::RouterBase<double>::RouteInfo &route) const {
+  // Путь имеет вид: посадка, перегоны, выход, посадка, ...
+  // Перегоны между посадкой и выходом собираются в одну поездку
+  RouteStat result{};
+  result.total_time = route.weight;
+  RouteItemBus bus_item{{}, 0, 0.};
+  for (const EdgeId edge_id : route.edges) {
+    const RideEdge &ride_edge = ride_edges_[edge_id];
+    const double weight = graph_->GetEdge(edge_id).weight;
+    switch (ride_edge.kind) {
+    case RideEdge::Kind::BOARD:
+      result.items.emplace_back(RouteItemStop{ride_edge.stop_name, weight});
+      bus_item = RouteItemBus{ride_edge.bus_name, 0, 0.};
+      break;
+    case RideEdge::Kind::RIDE:
+      ++bus_item.span_count;
+      bus_item.time += weight;
+      break;
+    case RideEdge::Kind::ALIGHT:
+      result.items.emplace_back(bus_item);
+      break;
     }
-    return result;
   }
-  return nullopt;
+  return result;
 }
 
 VertexId TransportRouterImpl::GetVertexIDByName(std::string_view stop_name) {
@@ -84,47 +490,60 @@ VertexId TransportRouterImpl::GetVertexIDByName(std::string_view stop_name) {
       iter != vertex_index_.end()) {
     return iter->second;
   }
-  vertex_index_.emplace(stop_name, vertex_counter_);
-  return vertex_counter_++;
+  const VertexId vertex_id = graph_->AddVertex();
+  vertex_index_.emplace(stop_name, vertex_id);
+  return vertex_id;
 }
 
-template <typename Iterator>
-void TransportRouterImpl::FillGraph(std::string_view bus_name, Iterator begin,
-                                    Iterator end, const Distances &distances) {
-
-  Distances loc_distances(distances);
+void TransportRouterImpl::FillGraph(std::string_view bus_name) {
   const double inverse_velocity = VELOCITY_CORRECTION / settings_.bus_velocity;
-  std::string prev_name{};
-  VertexId from_vertex_id{};
-  for (auto iter_from = begin; iter_from < prev(end); ++iter_from) {
-    double distance_cumulative{};
-    prev_name = iter_from->name;
-    from_vertex_id = GetVertexIDByName(iter_from->name);
-    for (auto iter_to = next(iter_from); iter_to < end; ++iter_to) {
-      //      if (const auto iter = distances.find({prev_name, iter_to->name});
-      //          iter != distances.end()) {
-      //        distance_cumulative += iter->second;
-      //      } else if (const auto mirror_iter =
-      //                     distances.find({iter_to->name, prev_name});
-      //                 mirror_iter != distances.end()) {
-      //        distance_cumulative += mirror_iter->second;
-      //      }
-      const double distance = loc_distances[{prev_name, iter_to->name}];
-      if (distance > 0) {
-        distance_cumulative += distance;
-      } else {
-        distance_cumulative += loc_distances[{iter_to->name, prev_name}];
-      }
-      prev_name = iter_to->name;
+  // номера вершин остановок рейса, чтобы не искать их для каждого ребра
+  std::vector<VertexId> vertex_ids;
+  vertex_ids.reserve(trip_stops_.size());
+  std::transform(trip_stops_.begin(), trip_stops_.end(),
+                 back_inserter(vertex_ids), [this](std::string_view stop_name) {
+                   return GetVertexIDByName(stop_name);
+                 });
+  for (size_t index_from = 0; index_from + 1 < vertex_ids.size();
+       ++index_from) {
+    for (size_t index_to = index_from + 1; index_to < vertex_ids.size();
+         ++index_to) {
+      const double distance =
+          trip_distances_[index_to] - trip_distances_[index_from];
       const graph::Edge<double> edge{
-          from_vertex_id, GetVertexIDByName(iter_to->name),
-          inverse_velocity * distance_cumulative + settings_.bus_wait};
-      const EdgeId edge_id = graph_->AddEdge(edge);
-      edge_index_.emplace(
-          edge_id, InternalEdge(iter_from->name,
-                                static_cast<uint>(
-                                    abs(std::distance(iter_to, iter_from))),
-                                edge.weight, bus_name));
+          vertex_ids[index_from], vertex_ids[index_to],
+          inverse_velocity * distance + settings_.bus_wait};
+      StoreEdgeInfo(edge_index_, PutEdge(edge),
+                    InternalEdge(trip_stops_[index_from],
+                                 static_cast<uint>(index_to - index_from),
+                                 edge.weight, bus_name));
+    }
+  }
+}
+
+void TransportRouterImpl::PutRideEdge(const graph::Edge<double> &edge,
+                                      RideEdge ride_edge) {
+  StoreEdgeInfo(ride_edges_, PutEdge(edge), ride_edge);
+}
+
+void TransportRouterImpl::FillRideGraph(std::string_view bus_name,
+                                        VertexId &ride_vertex) {
+  const double inverse_velocity = VELOCITY_CORRECTION / settings_.bus_velocity;
+  for (size_t index = 0; index < trip_stops_.size();
+       ++index, ++ride_vertex) {
+    const std::string_view stop_name = trip_stops_[index];
+    const VertexId stop_vertex = GetVertexIDByName(stop_name);
+    if (index != 0) {
+      PutRideEdge({ride_vertex, stop_vertex, 0.},
+                  {RideEdge::Kind::ALIGHT, stop_name, bus_name});
+    }
+    if (index + 1 != trip_stops_.size()) {
+      PutRideEdge({stop_vertex, ride_vertex, settings_.bus_wait},
+                  {RideEdge::Kind::BOARD, stop_name, bus_name});
+      PutRideEdge({ride_vertex, ride_vertex + 1,
+                   inverse_velocity *
+                       (trip_distances_[index + 1] - trip_distances_[index])},
+                  {RideEdge::Kind::RIDE, stop_name, bus_name});
     }
   }
 }
@@ -1,15 +1,39 @@
 #pragma once
+#include "ch_router.h"
+#include "dijkstra_router.h"
+#include "domain.h"
 #include "graph.h"
 #include "router.h"
-#include "domain.h"
+#include "transport_catalogue.h"
+#include <cstdint>
 #include <memory>
+#include <string>
 
 namespace transport {
 
 namespace router {
+// Способ поиска кратчайших маршрутов в графе
+enum class RouterMode {
+  PRECOMPUTED, // таблица маршрутов между всеми парами остановок при загрузке
+  PRECOMPUTED_COMPACT, // то же, таблица с весами float и 32-битными рёбрами
+  ON_DEMAND,   // алгоритм Дейкстры на каждый запрос, без предрасчёта
+  CONTRACTION_HIERARCHY, // иерархия сжатий, двунаправленный поиск на запрос
+};
+
+// Модель графа маршрутов
+enum class GraphModel {
+  STOP_TO_STOP, // ребро между каждой парой остановок автобуса, O(n^2) на рейс
+  RIDE_VERTICES, // вершина поездки на каждую остановку рейса, O(n) на рейс
+};
+
 struct RoutingSettings {
   double bus_wait{};
   double bus_velocity{};
+  RouterMode mode{RouterMode::PRECOMPUTED};
+  GraphModel graph_model{GraphModel::STOP_TO_STOP};
+  // файл с таблицами маршрутизатора: читается при совпадении графа и
+  // настроек, иначе записывается после построения. Пустой - не используется
+  std::string router_file{};
 };
 
 } // namespace router
@@ -20,22 +44,25 @@ public:
   static std::unique_ptr<TransportRouter> Make();
 
   virtual void SetSettings(const router::RoutingSettings &) = 0;
-  virtual void UploadData(size_t, const std::vector<BusInfo> &,
-                          const Distances &) = 0;
+  virtual void UploadData(size_t, const TransportCatalogue::RoutesView &) = 0;
+  // Добавляет автобус в построенный граф или обновляет расстояния его рейсов,
+  // перестраивая только затронутые части графа и маршрутизатора
+  virtual void UpdateBus(const TransportCatalogue::RouteView &) = 0;
   [[nodiscard]] virtual bool IsReady() = 0;
   [[nodiscard]] virtual std::optional<RouteStat>
-  FindRoute(const std::string &stop_from, const std::string &stop_to) const = 0;
+  FindRoute(std::string_view stop_from, std::string_view stop_to) const = 0;
 };
 
 class TransportRouterImpl : public TransportRouter {
 public:
   void SetSettings(const router::RoutingSettings & /*unused*/) override;
   [[nodiscard]] bool IsReady() override;
-  void UploadData(size_t stops_count, const std::vector<BusInfo> & /*unused*/,
-                  const Distances &distances) override;
+  void UploadData(size_t stops_count,
+                  const TransportCatalogue::RoutesView &routes) override;
+  void UpdateBus(const TransportCatalogue::RouteView &route) override;
   [[nodiscard]] std::optional<RouteStat>
-  FindRoute(const std::string &stop_from,
-            const std::string &stop_to) const override;
+  FindRoute(std::string_view stop_from,
+            std::string_view stop_to) const override;
 
 private:
   struct InternalEdge {
@@ -48,23 +75,76 @@ private:
     std::string_view bus_name;
   };
 
+  // Ребро модели RIDE_VERTICES: посадка, перегон или выход из автобуса
+  struct RideEdge {
+    enum class Kind { BOARD, RIDE, ALIGHT };
+    Kind kind;
+    std::string_view stop_name; // остановка посадки для BOARD
+    std::string_view bus_name;
+  };
+
+  // Рёбра [first_edge, last_edge) и вершины поездок автобуса в графе
+  struct BusEdges {
+    graph::EdgeId first_edge;
+    graph::EdgeId last_edge;
+    graph::VertexId first_ride_vertex;
+  };
+
   router::RoutingSettings settings_;
 
-  graph::VertexId vertex_counter_{};
   std::unordered_map<std::string_view, graph::VertexId> vertex_index_{};
+  std::unordered_map<std::string_view, BusEdges> bus_edges_{};
+  // при обновлении рейса - следующее перезаписываемое ребро
+  std::optional<graph::EdgeId> rewrite_edge_{};
+
+  // описание рёбер модели STOP_TO_STOP, индекс - EdgeId
+  std::vector<InternalEdge> edge_index_{};
+  // описание рёбер модели RIDE_VERTICES, индекс - EdgeId
+  std::vector<RideEdge> ride_edges_{};
 
-  std::unordered_map<graph::EdgeId, InternalEdge> edge_index_{};
+  // рабочие буферы рейса: остановки и расстояние от первой до каждой
+  std::vector<std::string_view> trip_stops_{};
+  std::vector<double> trip_distances_{};
 
   std::unique_ptr<graph::DirectedWeightedGraph<double>> graph_;
-  std::unique_ptr<graph::Router<double>> router_;
+  std::unique_ptr<graph::RouterBase<double>> router_;
 
   graph::VertexId GetVertexIDByName(std::string_view stop_name);
 
-  //  void FillGraph(const BusInfo &bus_info, const Distances &distances);
+  void MakeRouter();
+  // Таблицы маршрутизатора в файле settings_.router_file (режимы PRECOMPUTED*).
+  // Файл подходит, если совпадает отпечаток графа и настроек
+  [[nodiscard]] std::uint64_t GetGraphFingerprint() const;
+  bool LoadRouter();
+  // false - файл записать не удалось (нет прав, места и т.п.)
+  [[nodiscard]] bool SaveRouter() const;
+  // Обновляет маршрутизатор после изменения рёбер [first_edge, last_edge),
+  // при rebuild или невозможности обновления строит его заново
+  void UpdateRouter(graph::EdgeId first_edge, graph::EdgeId last_edge,
+                    bool rebuild);
+
+  void AddBus(const TransportCatalogue::RouteView &route);
+  // Добавляет рёбра рейсов автобуса или перезаписывает их веса
+  void FillBus(const TransportCatalogue::RouteView &route,
+               graph::VertexId ride_vertex);
+  // Собирает рейс в одном направлении в trip_stops_ и trip_distances_ и
+  // добавляет его рёбра
+  void FillTrip(const TransportCatalogue::RouteView &route, bool backward,
+                graph::VertexId &ride_vertex);
+  graph::EdgeId PutEdge(const graph::Edge<double> &edge);
+
+  // Добавляет рейс в модели STOP_TO_STOP: ребро между каждой парой остановок
+  void FillGraph(std::string_view bus_name);
+
+  // Добавляет рейс в модели RIDE_VERTICES: вершина поездки на каждую
+  // остановку, рёбра посадки (ожидание), перегонов и выхода
+  void FillRideGraph(std::string_view bus_name, graph::VertexId &ride_vertex);
+  void PutRideEdge(const graph::Edge<double> &edge, RideEdge ride_edge);
 
-  template <typename Iterator>
-  void FillGraph(std::string_view bus_name, Iterator begin, Iterator end,
-                 const Distances &distances);
+  [[nodiscard]] RouteStat
+  MakeRouteStat(const graph::RouterBase<double>::RouteInfo &route) const;
+  [[nodiscard]] RouteStat
+  MakeRideRouteStat(const graph::RouterBase<double>::RouteInfo &route) const;
 };
 
 } // namespace transport